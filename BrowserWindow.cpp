@@ -1,32 +1,121 @@
 #include "BrowserWindow.h"
+#include "MemoryPressureMonitor.h"
 #include "WebView.h"
+#include <QAction>
 #include <QStatusBar>
 
-BrowserWindow::BrowserWindow()
+BrowserWindow::BrowserWindow(size_t max_active_tabs)
+    : m_max_active_tabs(max_active_tabs)
 {
-    m_toolbar = new QToolBar;
-    m_location_edit = new QLineEdit;
-    m_toolbar->addWidget(m_location_edit);
+    m_tabs_container = new QTabWidget;
+    m_tabs_container->setTabsClosable(true);
+    m_tabs_container->setMovable(true);
+    m_tabs_container->setDocumentMode(true);
+    setCentralWidget(m_tabs_container);
 
-    addToolBar(m_toolbar);
+    auto* new_tab_action = new QAction("New &Tab", this);
+    new_tab_action->setShortcut(QKeySequence::AddTab);
+    addAction(new_tab_action);
 
-    m_view = new WebView;
-    setCentralWidget(m_view);
+    auto* close_tab_action = new QAction("&Close Tab", this);
+    close_tab_action->setShortcut(QKeySequence::Close);
+    addAction(close_tab_action);
 
-    QObject::connect(m_view, &WebView::linkHovered, statusBar(), &QStatusBar::showMessage);
-    QObject::connect(m_view, &WebView::linkUnhovered, statusBar(), &QStatusBar::clearMessage);
+    QObject::connect(new_tab_action, &QAction::triggered, this, [this] {
+        m_tabs_container->setCurrentWidget(&new_tab());
+    });
+    QObject::connect(close_tab_action, &QAction::triggered, this, [this] {
+        close_tab(m_tabs_container->currentIndex());
+    });
+    QObject::connect(m_tabs_container, &QTabWidget::currentChanged, this, &BrowserWindow::current_tab_changed);
+    QObject::connect(m_tabs_container, &QTabWidget::tabCloseRequested, this, &BrowserWindow::close_tab);
 
-    QObject::connect(m_view, &WebView::loadStarted, m_location_edit, &QLineEdit::setText);
-    QObject::connect(m_location_edit, &QLineEdit::returnPressed, this, &BrowserWindow::location_edit_return_pressed);
-    QObject::connect(m_view, &WebView::title_changed, this, &BrowserWindow::page_title_changed);
+    new_tab();
+
+    MemoryPressureMonitor::the().register_reclaimer("background tab backing stores", MemoryPressureLevel::Moderate, [this] {
+        return discard_background_tab_backing_stores();
+    });
+}
+
+Tab& BrowserWindow::new_tab()
+{
+    auto* tab = new Tab(this);
+    tab->view().set_active(false);
+    m_tabs_by_recency.append(tab);
+
+    QObject::connect(tab, &Tab::title_changed, this, [this, tab](QString title) {
+        tab_title_changed(tab, move(title));
+    });
+
+    m_tabs_container->addTab(tab, "New Tab");
+    return *tab;
+}
+
+void BrowserWindow::tab_title_changed(Tab* tab, QString title)
+{
+    auto index = m_tabs_container->indexOf(tab);
+    m_tabs_container->setTabText(index, title.isEmpty() ? "New Tab" : title);
+    if (tab == m_current_tab)
+        update_window_title(title);
+}
+
+void BrowserWindow::current_tab_changed(int index)
+{
+    auto* tab = static_cast<Tab*>(m_tabs_container->widget(index));
+    if (!tab)
+        return;
+
+    if (m_current_tab)
+        m_current_tab->view().set_active(false);
+    m_current_tab = tab;
+    m_current_tab->view().set_active(true);
+
+    m_tabs_by_recency.remove_first_matching([&](auto* other) { return other == tab; });
+    m_tabs_by_recency.prepend(tab);
+    throttle_background_tabs();
+
+    update_window_title(tab->title());
+}
+
+void BrowserWindow::close_tab(int index)
+{
+    if (m_tabs_container->count() <= 1) {
+        close();
+        return;
+    }
+
+    auto* tab = static_cast<Tab*>(m_tabs_container->widget(index));
+    if (!tab)
+        return;
+
+    if (tab == m_current_tab)
+        m_current_tab = nullptr;
+    m_tabs_by_recency.remove_first_matching([&](auto* other) { return other == tab; });
+    m_tabs_container->removeTab(index);
+    tab->deleteLater();
+}
+
+// Hidden tabs already stop reporting invalidations, skip painting and have their WebContent process deprioritized
+// (see WebView::set_active()). Beyond the most recently shown ones, they also give up their backing stores.
+// FIXME: Hidden tabs still run their JavaScript timers at their usual rate, only with less CPU to do it.
+//        Clamping those needs support in LibWeb.
+void BrowserWindow::throttle_background_tabs()
+{
+    for (size_t i = m_max_active_tabs; i < m_tabs_by_recency.size(); ++i)
+        m_tabs_by_recency[i]->view().discard_backing_store();
 }
 
-void BrowserWindow::location_edit_return_pressed()
+size_t BrowserWindow::discard_background_tab_backing_stores()
 {
-    view().load(m_location_edit->text().toUtf8().data());
+    size_t freed_bytes = 0;
+    for (auto* tab : m_tabs_by_recency) {
+        if (tab != m_current_tab)
+            freed_bytes += tab->view().discard_backing_store();
+    }
+    return freed_bytes;
 }
 
-void BrowserWindow::page_title_changed(QString title)
+void BrowserWindow::update_window_title(QString title)
 {
     if (title.isEmpty())
         setWindowTitle("Ladybird");
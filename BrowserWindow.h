@@ -1,6 +1,7 @@
-#include <QLineEdit>
+#include "Tab.h"
+#include <AK/Vector.h>
 #include <QMainWindow>
-#include <QToolBar>
+#include <QTabWidget>
 
 #pragma once
 
@@ -9,16 +10,26 @@ class WebView;
 class BrowserWindow : public QMainWindow {
     Q_OBJECT
 public:
-    BrowserWindow();
+    explicit BrowserWindow(size_t max_active_tabs);
 
-    WebView& view() { return *m_view; }
+    WebView& view() { return m_current_tab->view(); }
+
+    Tab& new_tab();
 
 public slots:
-    void location_edit_return_pressed();
-    void page_title_changed(QString);
+    void tab_title_changed(Tab*, QString);
+    void current_tab_changed(int index);
+    void close_tab(int index);
 
 private:
-    QToolBar* m_toolbar { nullptr };
-    QLineEdit* m_location_edit { nullptr };
-    WebView* m_view { nullptr };
+    void update_window_title(QString);
+    void throttle_background_tabs();
+    size_t discard_background_tab_backing_stores();
+
+    QTabWidget* m_tabs_container { nullptr };
+    Tab* m_current_tab { nullptr };
+
+    // Most recently shown first. Only the first m_max_active_tabs keep their backing stores while hidden.
+    Vector<Tab*> m_tabs_by_recency;
+    size_t m_max_active_tabs { 1 };
 };
@@ -0,0 +1,156 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#define AK_DONT_REPLACE_STD
+
+#include "ConnectionPool.h"
+#include <AK/Format.h>
+
+static constexpr int expiry_check_interval_ms = 1000;
+static constexpr int statistics_report_interval_ms = 30000;
+
+ConnectionPool& ConnectionPool::the()
+{
+    static ConnectionPool s_the;
+    return s_the;
+}
+
+String ConnectionPool::origin_key(AK::URL const& url, u16 default_port)
+{
+    return String::formatted("{}://{}:{}", url.protocol(), url.host(), url.port().value_or(default_port));
+}
+
+OwnPtr<Core::Stream::BufferedSocketBase> ConnectionPool::take(String const& origin)
+{
+    auto it = m_idle_connections.find(origin);
+    if (it == m_idle_connections.end())
+        return {};
+
+    auto& idle_connections = it->value;
+    while (!idle_connections.is_empty()) {
+        auto connection = idle_connections.take_last();
+        if (connection.idle_timer.elapsed() >= idle_timeout_ms)
+            continue;
+        // An idle connection has nothing to read, unless the server has closed it (or sent something it shouldn't have).
+        // This can't catch a close whose FIN is still on its way, which is why requests on reused connections may be retried.
+        auto can_read_or_error = connection.socket->can_read_without_blocking();
+        if (!connection.socket->is_open() || can_read_or_error.is_error() || can_read_or_error.value())
+            continue;
+        ++m_statistics.connections_reused;
+        return move(connection.socket);
+    }
+    m_idle_connections.remove(it);
+    return {};
+}
+
+void ConnectionPool::give_back(String const& origin, NonnullOwnPtr<Core::Stream::BufferedSocketBase> socket)
+{
+    if (!socket->is_open())
+        return;
+
+    auto& idle_connections = m_idle_connections.ensure(origin);
+    if (idle_connections.size() >= max_idle_connections_per_origin)
+        return;
+    idle_connections.append({ move(socket), Core::ElapsedTimer::start_new() });
+    start_expiry_timer();
+}
+
+ErrorOr<NonnullRefPtr<Http2Connection>> ConnectionPool::take_http2_connection(String const& origin, AK::URL const& url, u16 default_port)
+{
+    ++m_statistics.http2_streams;
+    if (auto connection = m_http2_connections.get(origin); connection.has_value() && (*connection)->can_start_streams()) {
+        ++m_statistics.connections_reused;
+        return NonnullRefPtr { *connection.value() };
+    }
+
+    // A connection that's going away keeps going for its open streams, which hold on to it until they're done.
+    m_http2_connections.remove(origin);
+    did_open_connection();
+    auto connection = TRY(Http2Connection::connect(url, default_port));
+    m_http2_connections.set(origin, connection);
+    start_expiry_timer();
+    return connection;
+}
+
+void ConnectionPool::did_open_connection()
+{
+    ++m_statistics.connections_opened;
+
+    if (!m_statistics_timer) {
+        m_statistics_timer = Core::Timer::create_repeating(statistics_report_interval_ms, [this] {
+            report_statistics();
+        });
+        m_statistics_timer->start();
+    }
+}
+
+void ConnectionPool::report_statistics()
+{
+    if (m_statistics == m_reported_statistics)
+        return;
+    m_reported_statistics = m_statistics;
+    dbgln("ConnectionPool: {} connections opened, {} reused, {} requests retried, {} HTTP/2 streams", m_statistics.connections_opened, m_statistics.connections_reused, m_statistics.requests_retried, m_statistics.http2_streams);
+}
+
+void ConnectionPool::start_expiry_timer()
+{
+    if (!m_expiry_timer) {
+        m_expiry_timer = Core::Timer::create_repeating(expiry_check_interval_ms, [this] {
+            close_expired_connections();
+        });
+    }
+    if (!m_expiry_timer->is_active())
+        m_expiry_timer->start();
+}
+
+void ConnectionPool::close_expired_connections()
+{
+    Vector<String> empty_origins;
+    for (auto& it : m_idle_connections) {
+        it.value.remove_all_matching([](auto& connection) {
+            return connection.idle_timer.elapsed() >= idle_timeout_ms;
+        });
+        if (it.value.is_empty())
+            empty_origins.append(it.key);
+    }
+    for (auto& origin : empty_origins)
+        m_idle_connections.remove(origin);
+
+    Vector<String> expired_http2_origins;
+    for (auto& it : m_http2_connections) {
+        if (!it.value->can_start_streams() || it.value->is_idle_for(idle_timeout_ms))
+            expired_http2_origins.append(it.key);
+    }
+    for (auto& origin : expired_http2_origins) {
+        auto connection = m_http2_connections.take(origin).release_value();
+        if (!connection->has_streams())
+            connection->close();
+    }
+
+    if (m_idle_connections.is_empty() && m_http2_connections.is_empty())
+        m_expiry_timer->stop();
+}
+
+size_t ConnectionPool::close_idle_connections()
+{
+    size_t count = 0;
+    for (auto& it : m_idle_connections)
+        count += it.value.size();
+    m_idle_connections.clear();
+
+    Vector<String> idle_http2_origins;
+    for (auto& it : m_http2_connections) {
+        if (!it.value->has_streams())
+            idle_http2_origins.append(it.key);
+    }
+    for (auto& origin : idle_http2_origins)
+        m_http2_connections.take(origin).release_value()->close();
+    count += idle_http2_origins.size();
+
+    if (m_expiry_timer && m_http2_connections.is_empty())
+        m_expiry_timer->stop();
+
+    dbgln("ConnectionPool: Closed {} idle connections", count);
+    return count;
+}
@@ -0,0 +1,83 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#define AK_DONT_REPLACE_STD
+
+#include "Http2Connection.h"
+#include <AK/HashMap.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/String.h>
+#include <AK/URL.h>
+#include <AK/Vector.h>
+#include <LibCore/ElapsedTimer.h>
+#include <LibCore/Stream.h>
+#include <LibCore/Timer.h>
+
+// Keeps HTTP(S) connections open once their request has finished, so the next request to the same origin
+// skips the TCP and TLS handshakes. HTTP/1.1 connections are only ever used for one request at a time.
+// With HTTP/2 prior knowledge, all http:// requests to an origin share one Http2Connection instead. HTTPS stays on
+// HTTP/1.1: using HTTP/2 there needs the TLS handshake to negotiate "h2" via ALPN, which we have no way to ask for.
+class ConnectionPool {
+public:
+    static constexpr size_t max_idle_connections_per_origin = 6;
+
+    // Kept below the keep-alive timeouts servers commonly use, so we rarely pick up a connection the server is closing.
+    static constexpr int idle_timeout_ms = 4000;
+
+    struct Statistics {
+        size_t connections_opened { 0 };
+        size_t connections_reused { 0 };
+        size_t requests_retried { 0 };
+        size_t http2_streams { 0 };
+
+        bool operator==(Statistics const&) const = default;
+    };
+
+    static ConnectionPool& the();
+
+    static String origin_key(AK::URL const&, u16 default_port);
+
+    // Returns an idle connection to the origin, if there's one the server hasn't closed yet.
+    OwnPtr<Core::Stream::BufferedSocketBase> take(String const& origin);
+    void give_back(String const& origin, NonnullOwnPtr<Core::Stream::BufferedSocketBase>);
+
+    // Only meant for servers known to speak HTTP/2, as there's no fallback to HTTP/1.1.
+    void set_http2_prior_knowledge(bool enabled) { m_http2_prior_knowledge = enabled; }
+    bool has_http2_prior_knowledge() const { return m_http2_prior_knowledge; }
+
+    // Returns the origin's HTTP/2 connection, or opens one if there's none that can take more streams.
+    ErrorOr<NonnullRefPtr<Http2Connection>> take_http2_connection(String const& origin, AK::URL const&, u16 default_port);
+
+    void did_open_connection();
+
+    // Called when a request on a reused connection failed before any response arrived and was sent again.
+    void did_retry_request() { ++m_statistics.requests_retried; }
+
+    // Closes all idle connections, including HTTP/2 connections without open streams, and returns how many there were.
+    size_t close_idle_connections();
+
+    Statistics const& statistics() const { return m_statistics; }
+
+private:
+    ConnectionPool() = default;
+
+    struct IdleConnection {
+        NonnullOwnPtr<Core::Stream::BufferedSocketBase> socket;
+        Core::ElapsedTimer idle_timer;
+    };
+
+    void start_expiry_timer();
+    void close_expired_connections();
+    void report_statistics();
+
+    HashMap<String, Vector<IdleConnection>> m_idle_connections;
+    HashMap<String, NonnullRefPtr<Http2Connection>> m_http2_connections;
+    bool m_http2_prior_knowledge { false };
+    RefPtr<Core::Timer> m_expiry_timer;
+    RefPtr<Core::Timer> m_statistics_timer;
+    Statistics m_statistics;
+    Statistics m_reported_statistics;
+};
@@ -0,0 +1,109 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#define AK_DONT_REPLACE_STD
+
+#include "ForkServer.h"
+#include <AK/Format.h>
+#include <AK/StringBuilder.h>
+#include <LibCore/System.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+static constexpr size_t max_url_length = 4 * KiB;
+
+// The URL is read before forking, so a client that never finishes sending one mustn't hold up everyone else for long.
+static constexpr int url_receive_timeout_ms = 2000;
+
+static ErrorOr<String> read_url_from_client(int client_fd)
+{
+    StringBuilder builder;
+    u8 buffer[512];
+    while (builder.length() < max_url_length) {
+        auto nread = TRY(Core::System::read(client_fd, { buffer, sizeof(buffer) }));
+        if (nread == 0)
+            break;
+        auto chunk = StringView { buffer, nread };
+        if (auto newline = chunk.find('\n'); newline.has_value()) {
+            builder.append(chunk.substring_view(0, *newline));
+            break;
+        }
+        builder.append(chunk);
+    }
+    return builder.string_view().trim_whitespace().to_string();
+}
+
+static ErrorOr<int> listen_on_local_socket(String const& socket_path)
+{
+    sockaddr_un address {};
+    address.sun_family = AF_LOCAL;
+    if (socket_path.length() >= sizeof(address.sun_path))
+        return Error::from_string_literal("Fork server socket path is too long");
+    memcpy(address.sun_path, socket_path.characters(), socket_path.length());
+
+    // A stale socket left behind by a previous fork server would make bind() fail. Anything else at that path
+    // is most likely a typo, and not ours to delete.
+    if (auto stat_or_error = Core::System::lstat(socket_path); !stat_or_error.is_error()) {
+        if (!S_ISSOCK(stat_or_error.value().st_mode))
+            return Error::from_string_literal("Fork server socket path exists and is not a socket");
+        TRY(Core::System::unlink(socket_path));
+    } else if (stat_or_error.error().code() != ENOENT) {
+        return stat_or_error.release_error();
+    }
+
+    auto server_fd = TRY(Core::System::socket(AF_LOCAL, SOCK_STREAM | SOCK_CLOEXEC, 0));
+    TRY(Core::System::bind(server_fd, reinterpret_cast<sockaddr const*>(&address), sizeof(address)));
+    TRY(Core::System::listen(server_fd, 16));
+    return server_fd;
+}
+
+ErrorOr<String> run_fork_server(String const& socket_path)
+{
+    auto server_fd = TRY(listen_on_local_socket(socket_path));
+    dbgln("Fork server listening on {}", socket_path);
+
+    // Children are never waited for, so let the kernel reap them.
+    TRY(Core::System::signal(SIGCHLD, SIG_IGN));
+
+    for (;;) {
+        auto client_fd_or_error = Core::System::accept(server_fd, nullptr, nullptr);
+        if (client_fd_or_error.is_error()) {
+            if (client_fd_or_error.error().code() == EINTR)
+                continue;
+            return client_fd_or_error.release_error();
+        }
+        auto client_fd = client_fd_or_error.release_value();
+
+        timeval receive_timeout { url_receive_timeout_ms / 1000, (url_receive_timeout_ms % 1000) * 1000 };
+        auto url_or_error = [&]() -> ErrorOr<String> {
+            TRY(Core::System::setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO, &receive_timeout, sizeof(receive_timeout)));
+            return read_url_from_client(client_fd);
+        }();
+        if (url_or_error.is_error()) {
+            warnln("Fork server: Failed to read URL: {}", url_or_error.error());
+            (void)Core::System::close(client_fd);
+            continue;
+        }
+
+        auto child_pid_or_error = Core::System::fork();
+        if (child_pid_or_error.is_error()) {
+            warnln("Fork server: Failed to fork: {}", child_pid_or_error.error());
+            (void)Core::System::close(client_fd);
+            continue;
+        }
+
+        if (child_pid_or_error.value() == 0) {
+            (void)Core::System::close(server_fd);
+            (void)Core::System::close(client_fd);
+            TRY(Core::System::signal(SIGCHLD, SIG_DFL));
+            return url_or_error.release_value();
+        }
+
+        dbgln("Fork server: Forked {} for '{}'", child_pid_or_error.value(), url_or_error.value());
+        (void)Core::System::close(client_fd);
+    }
+}
@@ -0,0 +1,15 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#define AK_DONT_REPLACE_STD
+
+#include <AK/Error.h>
+#include <AK/String.h>
+
+// Listens on a local socket at socket_path and forks a new browser process for every URL written to it.
+// The web engine must already be initialized so that every child starts out warm.
+// This only returns in the forked children, with the URL that the child should open.
+ErrorOr<String> run_fork_server(String const& socket_path);
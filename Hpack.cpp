@@ -0,0 +1,489 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#define AK_DONT_REPLACE_STD
+
+#include "Hpack.h"
+#include <AK/Array.h>
+#include <AK/StringView.h>
+
+struct StaticTableEntry {
+    StringView name;
+    StringView value;
+};
+
+// RFC 7541, Appendix A. Indices start at 1; the dynamic table follows it.
+static constexpr Array<StaticTableEntry, 61> s_static_table { {
+    { ":authority"sv, ""sv },
+    { ":method"sv, "GET"sv },
+    { ":method"sv, "POST"sv },
+    { ":path"sv, "/"sv },
+    { ":path"sv, "/index.html"sv },
+    { ":scheme"sv, "http"sv },
+    { ":scheme"sv, "https"sv },
+    { ":status"sv, "200"sv },
+    { ":status"sv, "204"sv },
+    { ":status"sv, "206"sv },
+    { ":status"sv, "304"sv },
+    { ":status"sv, "400"sv },
+    { ":status"sv, "404"sv },
+    { ":status"sv, "500"sv },
+    { "accept-charset"sv, ""sv },
+    { "accept-encoding"sv, "gzip, deflate"sv },
+    { "accept-language"sv, ""sv },
+    { "accept-ranges"sv, ""sv },
+    { "accept"sv, ""sv },
+    { "access-control-allow-origin"sv, ""sv },
+    { "age"sv, ""sv },
+    { "allow"sv, ""sv },
+    { "authorization"sv, ""sv },
+    { "cache-control"sv, ""sv },
+    { "content-disposition"sv, ""sv },
+    { "content-encoding"sv, ""sv },
+    { "content-language"sv, ""sv },
+    { "content-length"sv, ""sv },
+    { "content-location"sv, ""sv },
+    { "content-range"sv, ""sv },
+    { "content-type"sv, ""sv },
+    { "cookie"sv, ""sv },
+    { "date"sv, ""sv },
+    { "etag"sv, ""sv },
+    { "expect"sv, ""sv },
+    { "expires"sv, ""sv },
+    { "from"sv, ""sv },
+    { "host"sv, ""sv },
+    { "if-match"sv, ""sv },
+    { "if-modified-since"sv, ""sv },
+    { "if-none-match"sv, ""sv },
+    { "if-range"sv, ""sv },
+    { "if-unmodified-since"sv, ""sv },
+    { "last-modified"sv, ""sv },
+    { "link"sv, ""sv },
+    { "location"sv, ""sv },
+    { "max-forwards"sv, ""sv },
+    { "proxy-authenticate"sv, ""sv },
+    { "proxy-authorization"sv, ""sv },
+    { "range"sv, ""sv },
+    { "referer"sv, ""sv },
+    { "refresh"sv, ""sv },
+    { "retry-after"sv, ""sv },
+    { "server"sv, ""sv },
+    { "set-cookie"sv, ""sv },
+    { "strict-transport-security"sv, ""sv },
+    { "transfer-encoding"sv, ""sv },
+    { "user-agent"sv, ""sv },
+    { "vary"sv, ""sv },
+    { "via"sv, ""sv },
+    { "www-authenticate"sv, ""sv },
+} };
+
+struct HuffmanCode {
+    u32 code;
+    u8 length;
+};
+
+// RFC 7541, Appendix B. Symbol 256 is EOS.
+static constexpr Array<HuffmanCode, 257> s_huffman_codes { {
+    { 0x1ff8, 13 }, { 0x7fffd8, 23 }, { 0xfffffe2, 28 }, { 0xfffffe3, 28 },
+    { 0xfffffe4, 28 }, { 0xfffffe5, 28 }, { 0xfffffe6, 28 }, { 0xfffffe7, 28 },
+    { 0xfffffe8, 28 }, { 0xffffea, 24 }, { 0x3ffffffc, 30 }, { 0xfffffe9, 28 },
+    { 0xfffffea, 28 }, { 0x3ffffffd, 30 }, { 0xfffffeb, 28 }, { 0xfffffec, 28 },
+    { 0xfffffed, 28 }, { 0xfffffee, 28 }, { 0xfffffef, 28 }, { 0xffffff0, 28 },
+    { 0xffffff1, 28 }, { 0xffffff2, 28 }, { 0x3ffffffe, 30 }, { 0xffffff3, 28 },
+    { 0xffffff4, 28 }, { 0xffffff5, 28 }, { 0xffffff6, 28 }, { 0xffffff7, 28 },
+    { 0xffffff8, 28 }, { 0xffffff9, 28 }, { 0xffffffa, 28 }, { 0xffffffb, 28 },
+    { 0x14, 6 }, { 0x3f8, 10 }, { 0x3f9, 10 }, { 0xffa, 12 },
+    { 0x1ff9, 13 }, { 0x15, 6 }, { 0xf8, 8 }, { 0x7fa, 11 },
+    { 0x3fa, 10 }, { 0x3fb, 10 }, { 0xf9, 8 }, { 0x7fb, 11 },
+    { 0xfa, 8 }, { 0x16, 6 }, { 0x17, 6 }, { 0x18, 6 },
+    { 0x0, 5 }, { 0x1, 5 }, { 0x2, 5 }, { 0x19, 6 },
+    { 0x1a, 6 }, { 0x1b, 6 }, { 0x1c, 6 }, { 0x1d, 6 },
+    { 0x1e, 6 }, { 0x1f, 6 }, { 0x5c, 7 }, { 0xfb, 8 },
+    { 0x7ffc, 15 }, { 0x20, 6 }, { 0xffb, 12 }, { 0x3fc, 10 },
+    { 0x1ffa, 13 }, { 0x21, 6 }, { 0x5d, 7 }, { 0x5e, 7 },
+    { 0x5f, 7 }, { 0x60, 7 }, { 0x61, 7 }, { 0x62, 7 },
+    { 0x63, 7 }, { 0x64, 7 }, { 0x65, 7 }, { 0x66, 7 },
+    { 0x67, 7 }, { 0x68, 7 }, { 0x69, 7 }, { 0x6a, 7 },
+    { 0x6b, 7 }, { 0x6c, 7 }, { 0x6d, 7 }, { 0x6e, 7 },
+    { 0x6f, 7 }, { 0x70, 7 }, { 0x71, 7 }, { 0x72, 7 },
+    { 0xfc, 8 }, { 0x73, 7 }, { 0xfd, 8 }, { 0x1ffb, 13 },
+    { 0x7fff0, 19 }, { 0x1ffc, 13 }, { 0x3ffc, 14 }, { 0x22, 6 },
+    { 0x7ffd, 15 }, { 0x3, 5 }, { 0x23, 6 }, { 0x4, 5 },
+    { 0x24, 6 }, { 0x5, 5 }, { 0x25, 6 }, { 0x26, 6 },
+    { 0x27, 6 }, { 0x6, 5 }, { 0x74, 7 }, { 0x75, 7 },
+    { 0x28, 6 }, { 0x29, 6 }, { 0x2a, 6 }, { 0x7, 5 },
+    { 0x2b, 6 }, { 0x76, 7 }, { 0x2c, 6 }, { 0x8, 5 },
+    { 0x9, 5 }, { 0x2d, 6 }, { 0x77, 7 }, { 0x78, 7 },
+    { 0x79, 7 }, { 0x7a, 7 }, { 0x7b, 7 }, { 0x7ffe, 15 },
+    { 0x7fc, 11 }, { 0x3ffd, 14 }, { 0x1ffd, 13 }, { 0xffffffc, 28 },
+    { 0xfffe6, 20 }, { 0x3fffd2, 22 }, { 0xfffe7, 20 }, { 0xfffe8, 20 },
+    { 0x3fffd3, 22 }, { 0x3fffd4, 22 }, { 0x3fffd5, 22 }, { 0x7fffd9, 23 },
+    { 0x3fffd6, 22 }, { 0x7fffda, 23 }, { 0x7fffdb, 23 }, { 0x7fffdc, 23 },
+    { 0x7fffdd, 23 }, { 0x7fffde, 23 }, { 0xffffeb, 24 }, { 0x7fffdf, 23 },
+    { 0xffffec, 24 }, { 0xffffed, 24 }, { 0x3fffd7, 22 }, { 0x7fffe0, 23 },
+    { 0xffffee, 24 }, { 0x7fffe1, 23 }, { 0x7fffe2, 23 }, { 0x7fffe3, 23 },
+    { 0x7fffe4, 23 }, { 0x1fffdc, 21 }, { 0x3fffd8, 22 }, { 0x7fffe5, 23 },
+    { 0x3fffd9, 22 }, { 0x7fffe6, 23 }, { 0x7fffe7, 23 }, { 0xffffef, 24 },
+    { 0x3fffda, 22 }, { 0x1fffdd, 21 }, { 0xfffe9, 20 }, { 0x3fffdb, 22 },
+    { 0x3fffdc, 22 }, { 0x7fffe8, 23 }, { 0x7fffe9, 23 }, { 0x1fffde, 21 },
+    { 0x7fffea, 23 }, { 0x3fffdd, 22 }, { 0x3fffde, 22 }, { 0xfffff0, 24 },
+    { 0x1fffdf, 21 }, { 0x3fffdf, 22 }, { 0x7fffeb, 23 }, { 0x7fffec, 23 },
+    { 0x1fffe0, 21 }, { 0x1fffe1, 21 }, { 0x3fffe0, 22 }, { 0x1fffe2, 21 },
+    { 0x7fffed, 23 }, { 0x3fffe1, 22 }, { 0x7fffee, 23 }, { 0x7fffef, 23 },
+    { 0xfffea, 20 }, { 0x3fffe2, 22 }, { 0x3fffe3, 22 }, { 0x3fffe4, 22 },
+    { 0x7ffff0, 23 }, { 0x3fffe5, 22 }, { 0x3fffe6, 22 }, { 0x7ffff1, 23 },
+    { 0x3ffffe0, 26 }, { 0x3ffffe1, 26 }, { 0xfffeb, 20 }, { 0x7fff1, 19 },
+    { 0x3fffe7, 22 }, { 0x7ffff2, 23 }, { 0x3fffe8, 22 }, { 0x1ffffec, 25 },
+    { 0x3ffffe2, 26 }, { 0x3ffffe3, 26 }, { 0x3ffffe4, 26 }, { 0x7ffffde, 27 },
+    { 0x7ffffdf, 27 }, { 0x3ffffe5, 26 }, { 0xfffff1, 24 }, { 0x1ffffed, 25 },
+    { 0x7fff2, 19 }, { 0x1fffe3, 21 }, { 0x3ffffe6, 26 }, { 0x7ffffe0, 27 },
+    { 0x7ffffe1, 27 }, { 0x3ffffe7, 26 }, { 0x7ffffe2, 27 }, { 0xfffff2, 24 },
+    { 0x1fffe4, 21 }, { 0x1fffe5, 21 }, { 0x3ffffe8, 26 }, { 0x3ffffe9, 26 },
+    { 0xffffffd, 28 }, { 0x7ffffe3, 27 }, { 0x7ffffe4, 27 }, { 0x7ffffe5, 27 },
+    { 0xfffec, 20 }, { 0xfffff3, 24 }, { 0xfffed, 20 }, { 0x1fffe6, 21 },
+    { 0x3fffe9, 22 }, { 0x1fffe7, 21 }, { 0x1fffe8, 21 }, { 0x7ffff3, 23 },
+    { 0x3fffea, 22 }, { 0x3fffeb, 22 }, { 0x1ffffee, 25 }, { 0x1ffffef, 25 },
+    { 0xfffff4, 24 }, { 0xfffff5, 24 }, { 0x3ffffea, 26 }, { 0x7ffff4, 23 },
+    { 0x3ffffeb, 26 }, { 0x7ffffe6, 27 }, { 0x3ffffec, 26 }, { 0x3ffffed, 26 },
+    { 0x7ffffe7, 27 }, { 0x7ffffe8, 27 }, { 0x7ffffe9, 27 }, { 0x7ffffea, 27 },
+    { 0x7ffffeb, 27 }, { 0xffffffe, 28 }, { 0x7ffffec, 27 }, { 0x7ffffed, 27 },
+    { 0x7ffffee, 27 }, { 0x7ffffef, 27 }, { 0x7fffff0, 27 }, { 0x3ffffee, 26 },
+    { 0x3fffffff, 30 },
+} };
+
+static constexpr size_t entry_overhead = 32;
+
+static size_t entry_size(StringView name, StringView value)
+{
+    return name.length() + value.length() + entry_overhead;
+}
+
+// A binary tree over the codes, walked one bit at a time. Children are indices into the node list; a leaf has no
+// children and holds a symbol.
+struct HuffmanNode {
+    Array<i16, 2> children { -1, -1 };
+    i16 symbol { -1 };
+};
+
+static Vector<HuffmanNode> const& huffman_tree()
+{
+    static Vector<HuffmanNode> s_tree = [] {
+        Vector<HuffmanNode> tree;
+        tree.append({});
+        for (size_t symbol = 0; symbol < s_huffman_codes.size(); ++symbol) {
+            auto [code, length] = s_huffman_codes[symbol];
+            size_t node = 0;
+            for (int bit_index = length - 1; bit_index >= 0; --bit_index) {
+                auto bit = (code >> bit_index) & 1;
+                if (tree[node].children[bit] < 0) {
+                    tree[node].children[bit] = static_cast<i16>(tree.size());
+                    tree.append({});
+                }
+                node = tree[node].children[bit];
+            }
+            tree[node].symbol = static_cast<i16>(symbol);
+        }
+        return tree;
+    }();
+    return s_tree;
+}
+
+static ErrorOr<String> decode_huffman(ReadonlyBytes input)
+{
+    auto const& tree = huffman_tree();
+    Vector<u8> output;
+    size_t node = 0;
+    // Bits read since the last complete symbol, and whether they were all ones.
+    size_t pending_bits = 0;
+    bool pending_bits_are_ones = true;
+
+    for (auto byte : input) {
+        for (int bit_index = 7; bit_index >= 0; --bit_index) {
+            auto bit = (byte >> bit_index) & 1;
+            auto next = tree[node].children[bit];
+            if (next < 0)
+                return Error::from_string_literal("HPACK: Invalid Huffman code");
+            ++pending_bits;
+            pending_bits_are_ones &= bit == 1;
+
+            auto symbol = tree[next].symbol;
+            if (symbol < 0) {
+                node = next;
+                continue;
+            }
+            if (symbol == 256)
+                return Error::from_string_literal("HPACK: EOS in a Huffman-coded string");
+            output.append(static_cast<u8>(symbol));
+            node = 0;
+            pending_bits = 0;
+            pending_bits_are_ones = true;
+        }
+    }
+
+    // The last byte is padded with the most significant bits of EOS, which are all ones.
+    if (pending_bits > 7 || !pending_bits_are_ones)
+        return Error::from_string_literal("HPACK: Invalid Huffman padding");
+    return String { StringView { output.span() } };
+}
+
+class HpackReader {
+public:
+    explicit HpackReader(ReadonlyBytes bytes)
+        : m_bytes(bytes)
+    {
+    }
+
+    bool is_eof() const { return m_offset >= m_bytes.size(); }
+    u8 peek() const { return m_bytes[m_offset]; }
+
+    // RFC 7541, 5.1.
+    ErrorOr<u64> read_integer(u8 prefix_bits)
+    {
+        if (is_eof())
+            return Error::from_string_literal("HPACK: Truncated integer");
+        u64 max_prefix_value = (1u << prefix_bits) - 1;
+        u64 value = m_bytes[m_offset++] & max_prefix_value;
+        if (value < max_prefix_value)
+            return value;
+
+        for (u8 shift = 0;; shift += 7) {
+            if (is_eof())
+                return Error::from_string_literal("HPACK: Truncated integer");
+            // Nothing we accept comes close to this, so anything longer is an attack or garbage.
+            if (shift > 28)
+                return Error::from_string_literal("HPACK: Integer too large");
+            auto byte = m_bytes[m_offset++];
+            value += static_cast<u64>(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                return value;
+        }
+    }
+
+    // RFC 7541, 5.2.
+    ErrorOr<String> read_string()
+    {
+        if (is_eof())
+            return Error::from_string_literal("HPACK: Truncated string");
+        bool is_huffman_coded = peek() & 0x80;
+        auto length = TRY(read_integer(7));
+        if (length > m_bytes.size() - m_offset)
+            return Error::from_string_literal("HPACK: Truncated string");
+        auto bytes = m_bytes.slice(m_offset, length);
+        m_offset += length;
+        if (is_huffman_coded)
+            return decode_huffman(bytes);
+        return String { StringView { bytes } };
+    }
+
+private:
+    ReadonlyBytes m_bytes;
+    size_t m_offset { 0 };
+};
+
+ErrorOr<HpackHeader> HpackDecoder::header_at(u64 index) const
+{
+    if (index == 0)
+        return Error::from_string_literal("HPACK: Index 0");
+    if (index <= s_static_table.size()) {
+        auto const& entry = s_static_table[index - 1];
+        return HpackHeader { entry.name, entry.value };
+    }
+    index -= s_static_table.size() + 1;
+    if (index >= m_dynamic_table.size())
+        return Error::from_string_literal("HPACK: Index past the end of the dynamic table");
+    return m_dynamic_table[index];
+}
+
+void HpackDecoder::evict_to(size_t size)
+{
+    while (m_dynamic_table_size > size) {
+        auto evicted = m_dynamic_table.take_last();
+        m_dynamic_table_size -= entry_size(evicted.name, evicted.value);
+    }
+}
+
+void HpackDecoder::insert(HpackHeader header)
+{
+    // An entry larger than the table empties it and isn't added (RFC 7541, 4.4).
+    auto size = entry_size(header.name, header.value);
+    if (size > m_max_dynamic_table_size) {
+        evict_to(0);
+        return;
+    }
+    evict_to(m_max_dynamic_table_size - size);
+    m_dynamic_table.prepend(move(header));
+    m_dynamic_table_size += size;
+}
+
+ErrorOr<Vector<HpackHeader>> HpackDecoder::decode(ReadonlyBytes header_block)
+{
+    HpackReader reader { header_block };
+    Vector<HpackHeader> headers;
+    size_t header_list_size = 0;
+
+    while (!reader.is_eof()) {
+        auto first_byte = reader.peek();
+
+        if ((first_byte & 0xe0) == 0x20) {
+            // Dynamic table size update (RFC 7541, 6.3). Only allowed before the first header of a block.
+            if (!headers.is_empty())
+                return Error::from_string_literal("HPACK: Table size update after a header");
+            auto size = TRY(reader.read_integer(5));
+            if (size > max_dynamic_table_size)
+                return Error::from_string_literal("HPACK: Table size update above our limit");
+            m_max_dynamic_table_size = size;
+            evict_to(size);
+            continue;
+        }
+
+        HpackHeader header;
+        if (first_byte & 0x80) {
+            // Indexed header field (RFC 7541, 6.1).
+            header = TRY(header_at(TRY(reader.read_integer(7))));
+        } else {
+            // Literal header field, with incremental indexing (6.2.1), without indexing (6.2.2) or never indexed (6.2.3).
+            bool should_index = first_byte & 0x40;
+            auto name_index = TRY(reader.read_integer(should_index ? 6 : 4));
+            header.name = name_index == 0 ? TRY(reader.read_string()) : TRY(header_at(name_index)).name;
+            header.value = TRY(reader.read_string());
+            if (should_index)
+                insert(header);
+        }
+
+        header_list_size += entry_size(header.name, header.value);
+        if (header_list_size > max_header_list_size)
+            return Error::from_string_literal("HPACK: Header list too large");
+        headers.append(move(header));
+    }
+
+    return headers;
+}
+
+void HpackEncoder::set_max_dynamic_table_size(size_t size)
+{
+    // The peer's setting is only an upper bound for our table, and a bigger table doesn't pay off for requests.
+    size = min(size, max_dynamic_table_size);
+    if (size == m_max_dynamic_table_size)
+        return;
+
+    // If it shrinks and grows again before the next header block, the decoder still has to hear about the minimum.
+    if (!m_smallest_pending_table_size.has_value() || size < *m_smallest_pending_table_size)
+        m_smallest_pending_table_size = size;
+    m_max_dynamic_table_size = size;
+    evict_to(size);
+}
+
+Optional<size_t> HpackEncoder::find(HpackHeader const& header, bool& value_matches) const
+{
+    Optional<size_t> name_index;
+    value_matches = false;
+
+    for (size_t i = 0; i < s_static_table.size(); ++i) {
+        if (s_static_table[i].name != header.name)
+            continue;
+        if (s_static_table[i].value == header.value) {
+            value_matches = true;
+            return i + 1;
+        }
+        if (!name_index.has_value())
+            name_index = i + 1;
+    }
+
+    for (size_t i = 0; i < m_dynamic_table.size(); ++i) {
+        if (m_dynamic_table[i].name != header.name)
+            continue;
+        if (m_dynamic_table[i].value == header.value) {
+            value_matches = true;
+            return s_static_table.size() + 1 + i;
+        }
+        if (!name_index.has_value())
+            name_index = s_static_table.size() + 1 + i;
+    }
+
+    return name_index;
+}
+
+void HpackEncoder::evict_to(size_t size)
+{
+    while (m_dynamic_table_size > size) {
+        auto evicted = m_dynamic_table.take_last();
+        m_dynamic_table_size -= entry_size(evicted.name, evicted.value);
+    }
+}
+
+void HpackEncoder::insert(HpackHeader const& header)
+{
+    auto size = entry_size(header.name, header.value);
+    evict_to(m_max_dynamic_table_size - size);
+    m_dynamic_table.prepend(header);
+    m_dynamic_table_size += size;
+}
+
+// RFC 7541, 5.1. The first byte carries the representation's flags above the prefix.
+static void encode_integer(Vector<u8>& output, u8 flags, u8 prefix_bits, u64 value)
+{
+    u64 max_prefix_value = (1u << prefix_bits) - 1;
+    if (value < max_prefix_value) {
+        output.append(flags | static_cast<u8>(value));
+        return;
+    }
+    output.append(flags | static_cast<u8>(max_prefix_value));
+    value -= max_prefix_value;
+    while (value >= 0x80) {
+        output.append(static_cast<u8>(value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    output.append(static_cast<u8>(value));
+}
+
+static void encode_string(Vector<u8>& output, StringView string)
+{
+    encode_integer(output, 0, 7, string.length());
+    output.append(reinterpret_cast<u8 const*>(string.characters_without_null_termination()), string.length());
+}
+
+// Credentials shouldn't be recoverable by an intermediary that probes the table, so they're marked never indexed.
+static bool is_sensitive(StringView name)
+{
+    return name == "authorization"sv || name == "proxy-authorization"sv || name == "cookie"sv;
+}
+
+Vector<u8> HpackEncoder::encode(Vector<HpackHeader> const& headers)
+{
+    Vector<u8> output;
+
+    if (m_smallest_pending_table_size.has_value()) {
+        encode_integer(output, 0x20, 5, *m_smallest_pending_table_size);
+        if (*m_smallest_pending_table_size != m_max_dynamic_table_size)
+            encode_integer(output, 0x20, 5, m_max_dynamic_table_size);
+        m_smallest_pending_table_size.clear();
+    }
+
+    for (auto const& header : headers) {
+        bool value_matches = false;
+        auto index = find(header, value_matches);
+
+        if (index.has_value() && value_matches && !is_sensitive(header.name)) {
+            encode_integer(output, 0x80, 7, *index);
+            continue;
+        }
+
+        // The path changes with every request, so indexing it would only push out the headers that do repeat.
+        bool should_index = !is_sensitive(header.name) && header.name != ":path"sv
+            && entry_size(header.name, header.value) <= m_max_dynamic_table_size / 2;
+
+        if (should_index)
+            encode_integer(output, 0x40, 6, index.value_or(0));
+        else
+            encode_integer(output, is_sensitive(header.name) ? 0x10 : 0x00, 4, index.value_or(0));
+        if (!index.has_value())
+            encode_string(output, header.name);
+        encode_string(output, header.value);
+
+        if (should_index)
+            insert(header);
+    }
+
+    return output;
+}
@@ -0,0 +1,66 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#define AK_DONT_REPLACE_STD
+
+#include <AK/Error.h>
+#include <AK/Optional.h>
+#include <AK/String.h>
+#include <AK/Vector.h>
+
+// HPACK, the header compression of HTTP/2 (RFC 7541).
+struct HpackHeader {
+    String name;
+    String value;
+};
+
+// Both sides of a connection keep a table of recently sent headers, which later header blocks can refer to by index.
+// The decoder's table has to follow the peer's encoder exactly, so every header block received on a connection
+// must be decoded, in order.
+class HpackDecoder {
+public:
+    // We announce both in our SETTINGS.
+    static constexpr size_t max_dynamic_table_size = 4096;
+    static constexpr size_t max_header_list_size = 64 * KiB;
+
+    // Any error leaves the table in an unknown state, so it's fatal to the whole connection.
+    ErrorOr<Vector<HpackHeader>> decode(ReadonlyBytes header_block);
+
+private:
+    ErrorOr<HpackHeader> header_at(u64 index) const;
+    void insert(HpackHeader);
+    void evict_to(size_t size);
+
+    // Newest first, so that index 0 is the entry inserted last, as the indices count.
+    Vector<HpackHeader> m_dynamic_table;
+    size_t m_dynamic_table_size { 0 };
+
+    // Set by the peer's encoder through table size updates, up to max_dynamic_table_size.
+    size_t m_max_dynamic_table_size { max_dynamic_table_size };
+};
+
+// Headers that repeat across requests, which is most of them, are added to the table, so that later requests can
+// send them as a single index. Strings aren't Huffman coded: request headers are small, and we send few of them.
+class HpackEncoder {
+public:
+    static constexpr size_t max_dynamic_table_size = 4096;
+
+    // The peer's SETTINGS_HEADER_TABLE_SIZE. Takes effect at the start of the next header block.
+    void set_max_dynamic_table_size(size_t);
+
+    // Names must already be lowercase, as HTTP/2 requires.
+    Vector<u8> encode(Vector<HpackHeader> const&);
+
+private:
+    Optional<size_t> find(HpackHeader const&, bool& value_matches) const;
+    void insert(HpackHeader const&);
+    void evict_to(size_t size);
+
+    Vector<HpackHeader> m_dynamic_table;
+    size_t m_dynamic_table_size { 0 };
+    size_t m_max_dynamic_table_size { max_dynamic_table_size };
+    Optional<size_t> m_smallest_pending_table_size;
+};
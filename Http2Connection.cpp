@@ -0,0 +1,767 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#define AK_DONT_REPLACE_STD
+
+#include "Http2Connection.h"
+#include <AK/ByteBuffer.h>
+#include <AK/Format.h>
+#include <AK/LexicalPath.h>
+#include <LibCompress/Deflate.h>
+#include <LibCompress/Gzip.h>
+#include <LibCompress/Zlib.h>
+#include <LibCore/EventLoop.h>
+
+static constexpr StringView connection_preface = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"sv;
+static constexpr size_t frame_header_size = 9;
+
+// We don't announce a larger SETTINGS_MAX_FRAME_SIZE, so the server's frames can't be any bigger than the default.
+static constexpr size_t max_receive_frame_size = 16384;
+
+// Large enough that a single response isn't held back waiting for WINDOW_UPDATEs on a fast connection.
+static constexpr size_t stream_receive_window_size = 1 * MiB;
+static constexpr size_t connection_receive_window_size = 8 * MiB;
+static constexpr i64 default_window_size = 65535;
+static constexpr i64 max_window_size = 0x7fffffff;
+static constexpr u32 max_stream_id = 0x7fffffff;
+
+static constexpr u8 flag_end_stream = 0x1;
+static constexpr u8 flag_ack = 0x1;
+static constexpr u8 flag_end_headers = 0x4;
+static constexpr u8 flag_padded = 0x8;
+static constexpr u8 flag_priority = 0x20;
+
+enum class SettingsParameter : u16 {
+    HeaderTableSize = 0x1,
+    EnablePush = 0x2,
+    MaxConcurrentStreams = 0x3,
+    InitialWindowSize = 0x4,
+    MaxFrameSize = 0x5,
+    MaxHeaderListSize = 0x6,
+};
+
+static void append_u16(Vector<u8>& output, u16 value)
+{
+    output.append(value >> 8);
+    output.append(value & 0xff);
+}
+
+static void append_u32(Vector<u8>& output, u32 value)
+{
+    output.append(value >> 24);
+    output.append((value >> 16) & 0xff);
+    output.append((value >> 8) & 0xff);
+    output.append(value & 0xff);
+}
+
+static u32 read_u32(ReadonlyBytes bytes)
+{
+    return (bytes[0] << 24) | (bytes[1] << 16) | (bytes[2] << 8) | bytes[3];
+}
+
+// Render-blocking resources go first, images and everything else share what's left. The weights only take effect
+// with servers that still honor RFC 7540 priorities, but they cost nothing with those that don't.
+static u8 weight_for(AK::URL const& url)
+{
+    LexicalPath path { url.path() };
+    auto extension = path.extension();
+    if (extension.is_empty() || extension.equals_ignoring_case("html"sv) || extension.equals_ignoring_case("css"sv) || extension.equals_ignoring_case("js"sv))
+        return 255;
+    if (extension.equals_ignoring_case("woff"sv) || extension.equals_ignoring_case("woff2"sv) || extension.equals_ignoring_case("ttf"sv))
+        return 127;
+    return 31;
+}
+
+// Headers that only mean something for a single HTTP/1.1 connection, which HTTP/2 forbids (RFC 9113, 8.2.2).
+// The host becomes the :authority pseudo-header instead.
+static bool is_connection_specific_header(StringView name)
+{
+    return name == "connection"sv || name == "keep-alive"sv || name == "proxy-connection"sv
+        || name == "transfer-encoding"sv || name == "upgrade"sv || name == "host"sv;
+}
+
+static Optional<ByteBuffer> decode_content(Vector<u8> const& body, String const& content_encoding)
+{
+    if (content_encoding.equals_ignoring_case("gzip"sv))
+        return Compress::GzipDecompressor::decompress_all(body.span());
+
+    // Servers disagree on whether "deflate" has a zlib header, so both are accepted, like HTTP::Job does.
+    auto decoded = Compress::Zlib::decompress_all(body.span());
+    if (decoded.has_value())
+        return decoded;
+    return Compress::DeflateDecompressor::decompress_all(body.span());
+}
+
+ErrorOr<NonnullRefPtr<Http2Connection>> Http2Connection::connect(AK::URL const& url, u16 default_port)
+{
+    auto socket = TRY(Core::Stream::TCPSocket::connect(url.host(), url.port().value_or(default_port)));
+    auto connection = adopt_ref(*new Http2Connection(move(socket)));
+    if (connection->send_preface().is_error())
+        return Error::from_string_literal("Failed to send the HTTP/2 connection preface");
+    return connection;
+}
+
+Http2Connection::Http2Connection(NonnullOwnPtr<Core::Stream::TCPSocket> socket)
+    : m_socket(move(socket))
+{
+    m_idle_timer.start();
+    m_socket->on_ready_to_read = [this] {
+        did_become_readable();
+    };
+}
+
+Http2Connection::~Http2Connection()
+{
+    m_socket->on_ready_to_read = nullptr;
+}
+
+Http2Connection::ProtocolResult Http2Connection::send_preface()
+{
+    TRY(write(connection_preface.bytes()));
+
+    Vector<u8> settings;
+    auto append_setting = [&](SettingsParameter parameter, u32 value) {
+        append_u16(settings, to_underlying(parameter));
+        append_u32(settings, value);
+    };
+    append_setting(SettingsParameter::EnablePush, 0);
+    append_setting(SettingsParameter::InitialWindowSize, stream_receive_window_size);
+    append_setting(SettingsParameter::MaxHeaderListSize, HpackDecoder::max_header_list_size);
+    TRY(send_frame(FrameType::Settings, 0, 0, settings.span()));
+
+    // The connection window can only be raised by a WINDOW_UPDATE, not by a setting.
+    TRY(send_window_update(0, connection_receive_window_size - default_window_size));
+    m_connection_receive_window = connection_receive_window_size;
+    return {};
+}
+
+Http2Connection::ProtocolResult Http2Connection::write(ReadonlyBytes bytes)
+{
+    if (!m_socket->write_or_error(bytes))
+        return ProtocolError { ErrorCode::InternalError, "Failed to write to the socket"sv };
+    return {};
+}
+
+Http2Connection::ProtocolResult Http2Connection::send_frame(FrameType type, u8 flags, u32 stream_id, ReadonlyBytes payload)
+{
+    Vector<u8> frame;
+    frame.ensure_capacity(frame_header_size + payload.size());
+    frame.append((payload.size() >> 16) & 0xff);
+    frame.append((payload.size() >> 8) & 0xff);
+    frame.append(payload.size() & 0xff);
+    frame.append(to_underlying(type));
+    frame.append(flags);
+    append_u32(frame, stream_id);
+    frame.append(payload.data(), payload.size());
+    return write(frame.span());
+}
+
+Http2Connection::ProtocolResult Http2Connection::send_window_update(u32 stream_id, u32 increment)
+{
+    Vector<u8> payload;
+    append_u32(payload, increment);
+    return send_frame(FrameType::WindowUpdate, 0, stream_id, payload.span());
+}
+
+void Http2Connection::send_rst_stream(u32 stream_id, ErrorCode error_code)
+{
+    Vector<u8> payload;
+    append_u32(payload, to_underlying(error_code));
+    // If this fails, so will the next read, which takes care of the connection.
+    (void)send_frame(FrameType::RstStream, 0, stream_id, payload.span());
+}
+
+Http2Connection::StreamToken Http2Connection::start_stream(HTTP::HttpRequest const& request, StreamCallbacks callbacks)
+{
+    auto const& url = request.url();
+    auto stream = make<Stream>();
+    stream->token = m_next_stream_token++;
+    stream->weight = weight_for(url);
+    stream->callbacks = move(callbacks);
+    stream->request_body.append(request.body().data(), request.body().size());
+
+    auto path = AK::URL::percent_encode(url.path(), AK::URL::PercentEncodeSet::EncodeURI);
+    if (path.is_empty())
+        path = "/";
+    if (!url.query().is_empty())
+        path = String::formatted("{}?{}", path, url.query());
+
+    auto& headers = stream->request_headers;
+    headers.append({ ":method", request.method_name() });
+    headers.append({ ":scheme", "http" });
+    headers.append({ ":authority", url.port().has_value() ? String::formatted("{}:{}", url.host(), *url.port()) : url.host() });
+    headers.append({ ":path", path });
+
+    bool has_accept_encoding = false;
+    bool has_content_length = false;
+    for (auto& header : request.headers()) {
+        auto name = header.name.to_lowercase();
+        if (is_connection_specific_header(name))
+            continue;
+        has_accept_encoding |= name == "accept-encoding"sv;
+        has_content_length |= name == "content-length"sv;
+        headers.append({ move(name), header.value });
+    }
+    if (!has_accept_encoding)
+        headers.append({ "accept-encoding", "gzip, deflate" });
+    if (!has_content_length && !stream->request_body.is_empty())
+        headers.append({ "content-length", String::number(stream->request_body.size()) });
+
+    auto token = stream->token;
+    m_queued_streams.append(move(stream));
+    start_queued_streams();
+    return token;
+}
+
+void Http2Connection::cancel_stream(StreamToken token)
+{
+    m_queued_streams.remove_first_matching([&](auto& stream) { return stream->token == token; });
+
+    Optional<u32> stream_id;
+    for (auto& it : m_streams) {
+        if (it.value->token == token)
+            stream_id = it.key;
+    }
+    if (stream_id.has_value()) {
+        m_streams.remove(*stream_id);
+        send_rst_stream(*stream_id, ErrorCode::Cancel);
+    }
+
+    did_finish_a_stream();
+}
+
+void Http2Connection::start_queued_streams()
+{
+    while (!m_queued_streams.is_empty() && can_start_streams() && m_streams.size() < m_max_concurrent_streams) {
+        // Stream IDs can't be reused, so a connection that has used them all up has to make way for a new one.
+        if (m_next_stream_id > max_stream_id) {
+            m_is_going_away = true;
+            break;
+        }
+
+        auto stream = m_queued_streams.take_first();
+        stream->id = m_next_stream_id;
+        stream->send_window = m_initial_send_window;
+        stream->receive_window = stream_receive_window_size;
+        m_next_stream_id += 2;
+
+        auto stream_id = stream->id;
+        auto& stream_reference = *stream;
+        m_streams.set(stream_id, move(stream));
+        if (auto result = send_headers(stream_reference); result.is_error()) {
+            fail_connection(result.error());
+            return;
+        }
+    }
+
+    if (auto result = send_request_bodies(); result.is_error()) {
+        fail_connection(result.error());
+        return;
+    }
+
+    if (!can_start_streams()) {
+        // Whatever is still waiting has never been sent, so it's safe to send it again on another connection.
+        auto queued_streams = move(m_queued_streams);
+        for (auto& stream : queued_streams)
+            call_on_finish(*stream, StreamResult::Refused);
+    }
+}
+
+Http2Connection::ProtocolResult Http2Connection::send_headers(Stream& stream)
+{
+    Vector<u8> payload;
+    // No dependency on another stream, only a weight relative to the others.
+    append_u32(payload, 0);
+    payload.append(stream.weight);
+    auto header_block = m_hpack_encoder.encode(stream.request_headers);
+    payload.append(header_block.data(), header_block.size());
+    stream.request_headers.clear();
+
+    u8 flags = flag_priority;
+    if (stream.request_body.is_empty()) {
+        flags |= flag_end_stream;
+        stream.has_sent_end_stream = true;
+    }
+
+    // A header block larger than a frame continues in CONTINUATION frames, with nothing in between.
+    auto remaining = payload.span();
+    auto first_fragment = remaining.trim(m_max_send_frame_size);
+    remaining = remaining.slice(first_fragment.size());
+    TRY(send_frame(FrameType::Headers, flags | (remaining.is_empty() ? flag_end_headers : 0), stream.id, first_fragment));
+    while (!remaining.is_empty()) {
+        auto fragment = remaining.trim(m_max_send_frame_size);
+        remaining = remaining.slice(fragment.size());
+        TRY(send_frame(FrameType::Continuation, remaining.is_empty() ? flag_end_headers : 0, stream.id, fragment));
+    }
+    return {};
+}
+
+Http2Connection::ProtocolResult Http2Connection::send_request_bodies()
+{
+    for (auto& it : m_streams) {
+        auto& stream = *it.value;
+        while (!stream.has_sent_end_stream && m_connection_send_window > 0 && stream.send_window > 0) {
+            auto remaining = stream.request_body.size() - stream.request_body_offset;
+            auto size = min(remaining, static_cast<size_t>(m_connection_send_window), static_cast<size_t>(stream.send_window), m_max_send_frame_size);
+            bool is_last = size == remaining;
+            TRY(send_frame(FrameType::Data, is_last ? flag_end_stream : 0, stream.id, stream.request_body.span().slice(stream.request_body_offset, size)));
+            stream.request_body_offset += size;
+            stream.send_window -= size;
+            m_connection_send_window -= size;
+            if (is_last) {
+                stream.has_sent_end_stream = true;
+                stream.request_body.clear();
+            }
+        }
+    }
+    return {};
+}
+
+void Http2Connection::did_become_readable()
+{
+    NonnullRefPtr protector = *this;
+
+    u8 buffer[16 * KiB];
+    auto bytes_or_error = m_socket->read({ buffer, sizeof(buffer) });
+    if (bytes_or_error.is_error()) {
+        dbgln("Http2Connection: Failed to read from the socket: {}", bytes_or_error.error());
+        fail_connection({ ErrorCode::InternalError, "Failed to read from the socket"sv });
+        return;
+    }
+    auto bytes = bytes_or_error.release_value();
+    if (bytes.is_empty()) {
+        // The server closed the connection. If it said goodbye first, streams it never processed are refused already.
+        if (has_streams())
+            dbgln("Http2Connection: The server closed the connection with {} streams still open", m_streams.size());
+        close_socket();
+        return;
+    }
+
+    m_receive_buffer.append(bytes.data(), bytes.size());
+    if (auto result = process_frames(); result.is_error())
+        fail_connection(result.error());
+}
+
+Http2Connection::ProtocolResult Http2Connection::process_frames()
+{
+    size_t offset = 0;
+    while (m_receive_buffer.size() - offset >= frame_header_size) {
+        auto header_bytes = m_receive_buffer.span().slice(offset, frame_header_size);
+        FrameHeader header;
+        header.length = (header_bytes[0] << 16) | (header_bytes[1] << 8) | header_bytes[2];
+        header.type = static_cast<FrameType>(header_bytes[3]);
+        header.flags = header_bytes[4];
+        header.stream_id = read_u32(header_bytes.slice(5)) & max_stream_id;
+
+        // A server that doesn't speak HTTP/2 answers the preface with an HTTP/1.1 error, which doesn't parse as a
+        // SETTINGS frame.
+        if (!m_has_received_settings && header.type != FrameType::Settings)
+            return ProtocolError { ErrorCode::ProtocolError, "The server didn't start with SETTINGS; does it speak HTTP/2?"sv };
+        if (header.length > max_receive_frame_size)
+            return ProtocolError { ErrorCode::FrameSizeError, "Frame larger than SETTINGS_MAX_FRAME_SIZE"sv };
+        if (m_receive_buffer.size() - offset < frame_header_size + header.length)
+            break;
+
+        auto payload = m_receive_buffer.span().slice(offset + frame_header_size, header.length);
+        TRY(process_frame(header, payload));
+        // The frame may have been the last thing a closing connection had to do, which discards the buffer.
+        if (!m_socket->is_open())
+            return {};
+        offset += frame_header_size + header.length;
+    }
+
+    m_receive_buffer.remove(0, offset);
+    return {};
+}
+
+Http2Connection::ProtocolResult Http2Connection::process_frame(FrameHeader const& header, ReadonlyBytes payload)
+{
+    if (m_continued_stream_id.has_value() && (header.type != FrameType::Continuation || header.stream_id != *m_continued_stream_id))
+        return ProtocolError { ErrorCode::ProtocolError, "Header block interrupted by another frame"sv };
+
+    switch (header.type) {
+    case FrameType::Data:
+        return process_data(header, payload);
+
+    case FrameType::Headers: {
+        if (header.stream_id == 0)
+            return ProtocolError { ErrorCode::ProtocolError, "HEADERS on stream 0"sv };
+        auto header_block = payload;
+        if (header.flags & flag_padded) {
+            if (header_block.is_empty() || header_block[0] >= header_block.size())
+                return ProtocolError { ErrorCode::ProtocolError, "Invalid padding"sv };
+            header_block = header_block.slice(1, header_block.size() - 1 - header_block[0]);
+        }
+        if (header.flags & flag_priority) {
+            if (header_block.size() < 5)
+                return ProtocolError { ErrorCode::FrameSizeError, "HEADERS too short for its priority"sv };
+            header_block = header_block.slice(5);
+        }
+        bool end_stream = header.flags & flag_end_stream;
+        if (header.flags & flag_end_headers)
+            return process_header_block(header.stream_id, end_stream, header_block);
+        m_continued_stream_id = header.stream_id;
+        m_continued_stream_ends = end_stream;
+        m_continued_header_block.append(header_block.data(), header_block.size());
+        return {};
+    }
+
+    case FrameType::Continuation: {
+        if (!m_continued_stream_id.has_value())
+            return ProtocolError { ErrorCode::ProtocolError, "CONTINUATION without HEADERS"sv };
+        m_continued_header_block.append(payload.data(), payload.size());
+        if (m_continued_header_block.size() > HpackDecoder::max_header_list_size)
+            return ProtocolError { ErrorCode::ProtocolError, "Header block too large"sv };
+        if (!(header.flags & flag_end_headers))
+            return {};
+        auto header_block = move(m_continued_header_block);
+        auto stream_id = m_continued_stream_id.release_value();
+        return process_header_block(stream_id, m_continued_stream_ends, header_block.span());
+    }
+
+    case FrameType::RstStream: {
+        if (header.stream_id == 0)
+            return ProtocolError { ErrorCode::ProtocolError, "RST_STREAM on stream 0"sv };
+        if (payload.size() != 4)
+            return ProtocolError { ErrorCode::FrameSizeError, "RST_STREAM of the wrong size"sv };
+        auto error_code = static_cast<ErrorCode>(read_u32(payload));
+        finish_stream(header.stream_id, error_code == ErrorCode::RefusedStream ? StreamResult::Refused : StreamResult::Failed);
+        return {};
+    }
+
+    case FrameType::Settings:
+        return process_settings(header, payload);
+
+    case FrameType::PushPromise:
+        return ProtocolError { ErrorCode::ProtocolError, "PUSH_PROMISE after we disabled push"sv };
+
+    case FrameType::Ping:
+        if (header.stream_id != 0)
+            return ProtocolError { ErrorCode::ProtocolError, "PING on a stream"sv };
+        if (payload.size() != 8)
+            return ProtocolError { ErrorCode::FrameSizeError, "PING of the wrong size"sv };
+        if (header.flags & flag_ack)
+            return {};
+        return send_frame(FrameType::Ping, flag_ack, 0, payload);
+
+    case FrameType::GoAway:
+        return process_go_away(payload);
+
+    case FrameType::WindowUpdate:
+        return process_window_update(header, payload);
+
+    case FrameType::Priority:
+    default:
+        // Priorities are for the server to act on, and unknown frame types must be ignored.
+        return {};
+    }
+}
+
+Http2Connection::ProtocolResult Http2Connection::process_data(FrameHeader const& header, ReadonlyBytes payload)
+{
+    if (header.stream_id == 0)
+        return ProtocolError { ErrorCode::ProtocolError, "DATA on stream 0"sv };
+
+    // Flow control counts the whole payload, padding included, whether or not the stream is still around.
+    m_connection_receive_window -= payload.size();
+    if (m_connection_receive_window < 0)
+        return ProtocolError { ErrorCode::FlowControlError, "DATA beyond the connection window"sv };
+    m_received_since_connection_window_update += payload.size();
+    if (m_received_since_connection_window_update >= connection_receive_window_size / 2) {
+        TRY(send_window_update(0, m_received_since_connection_window_update));
+        m_connection_receive_window += m_received_since_connection_window_update;
+        m_received_since_connection_window_update = 0;
+    }
+
+    auto data = payload;
+    if (header.flags & flag_padded) {
+        if (data.is_empty() || data[0] >= data.size())
+            return ProtocolError { ErrorCode::ProtocolError, "Invalid padding"sv };
+        data = data.slice(1, data.size() - 1 - data[0]);
+    }
+
+    // We may have cancelled the stream while this was on its way.
+    auto it = m_streams.find(header.stream_id);
+    if (it == m_streams.end())
+        return {};
+    auto& stream = *it->value;
+
+    if (!stream.has_final_response) {
+        send_rst_stream(stream.id, ErrorCode::ProtocolError);
+        finish_stream(stream.id, StreamResult::Failed);
+        return {};
+    }
+
+    stream.receive_window -= payload.size();
+    if (stream.receive_window < 0)
+        return ProtocolError { ErrorCode::FlowControlError, "DATA beyond the stream window"sv };
+
+    bool end_stream = header.flags & flag_end_stream;
+    if (!end_stream) {
+        stream.received_since_window_update += payload.size();
+        if (stream.received_since_window_update >= stream_receive_window_size / 2) {
+            TRY(send_window_update(stream.id, stream.received_since_window_update));
+            stream.receive_window += stream.received_since_window_update;
+            stream.received_since_window_update = 0;
+        }
+    }
+
+    // The callback may cancel the stream, so it's looked up again afterwards.
+    auto stream_id = stream.id;
+    if (!stream.content_encoding.is_null())
+        stream.encoded_body.append(data.data(), data.size());
+    else if (!data.is_empty() && stream.callbacks.on_data_received)
+        stream.callbacks.on_data_received(data);
+
+    if (end_stream)
+        finish_stream(stream_id, StreamResult::Complete);
+    return {};
+}
+
+Http2Connection::ProtocolResult Http2Connection::process_header_block(u32 stream_id, bool end_stream, ReadonlyBytes header_block)
+{
+    // Even a block for a stream we've given up on has to be decoded, or our table would fall out of step with the server's.
+    auto headers_or_error = m_hpack_decoder.decode(header_block);
+    if (headers_or_error.is_error()) {
+        dbgln("Http2Connection: {}", headers_or_error.error());
+        return ProtocolError { ErrorCode::CompressionError, "Failed to decode a header block"sv };
+    }
+
+    auto it = m_streams.find(stream_id);
+    if (it == m_streams.end())
+        return {};
+    auto& stream = *it->value;
+
+    if (stream.has_final_response) {
+        // Trailers, which nothing here has a use for.
+        if (end_stream)
+            finish_stream(stream_id, StreamResult::Complete);
+        return {};
+    }
+
+    Optional<u32> status_code;
+    HashMap<String, String, CaseInsensitiveStringTraits> response_headers;
+    for (auto& header : headers_or_error.value()) {
+        if (header.name == ":status"sv)
+            status_code = header.value.to_uint();
+        else if (!header.name.starts_with(':'))
+            response_headers.set(header.name, header.value);
+    }
+
+    if (!status_code.has_value()) {
+        send_rst_stream(stream_id, ErrorCode::ProtocolError);
+        finish_stream(stream_id, StreamResult::Failed);
+        return {};
+    }
+
+    // Informational responses come ahead of the real one.
+    if (*status_code >= 100 && *status_code < 200)
+        return {};
+
+    stream.has_final_response = true;
+    if (auto content_encoding = response_headers.get("content-encoding"sv); content_encoding.has_value()) {
+        if (content_encoding->equals_ignoring_case("gzip"sv) || content_encoding->equals_ignoring_case("deflate"sv))
+            stream.content_encoding = *content_encoding;
+    }
+    if (stream.callbacks.on_headers_received)
+        stream.callbacks.on_headers_received(response_headers, *status_code);
+
+    if (end_stream)
+        finish_stream(stream_id, StreamResult::Complete);
+    return {};
+}
+
+Http2Connection::ProtocolResult Http2Connection::process_settings(FrameHeader const& header, ReadonlyBytes payload)
+{
+    if (header.stream_id != 0)
+        return ProtocolError { ErrorCode::ProtocolError, "SETTINGS on a stream"sv };
+    if (header.flags & flag_ack) {
+        if (!payload.is_empty())
+            return ProtocolError { ErrorCode::FrameSizeError, "SETTINGS acknowledgement with a payload"sv };
+        return {};
+    }
+    if (payload.size() % 6 != 0)
+        return ProtocolError { ErrorCode::FrameSizeError, "SETTINGS of the wrong size"sv };
+
+    for (size_t offset = 0; offset < payload.size(); offset += 6) {
+        auto parameter = static_cast<SettingsParameter>((payload[offset] << 8) | payload[offset + 1]);
+        auto value = read_u32(payload.slice(offset + 2));
+        switch (parameter) {
+        case SettingsParameter::HeaderTableSize:
+            m_hpack_encoder.set_max_dynamic_table_size(value);
+            break;
+        case SettingsParameter::MaxConcurrentStreams:
+            m_max_concurrent_streams = value;
+            break;
+        case SettingsParameter::InitialWindowSize: {
+            if (value > max_window_size)
+                return ProtocolError { ErrorCode::FlowControlError, "SETTINGS_INITIAL_WINDOW_SIZE too large"sv };
+            // The change applies to the windows of open streams as well (RFC 9113, 6.9.2).
+            auto delta = static_cast<i64>(value) - m_initial_send_window;
+            for (auto& it : m_streams) {
+                it.value->send_window += delta;
+                if (it.value->send_window > max_window_size)
+                    return ProtocolError { ErrorCode::FlowControlError, "Stream window too large"sv };
+            }
+            m_initial_send_window = value;
+            break;
+        }
+        case SettingsParameter::MaxFrameSize:
+            if (value < 16384 || value > 16777215)
+                return ProtocolError { ErrorCode::ProtocolError, "Invalid SETTINGS_MAX_FRAME_SIZE"sv };
+            m_max_send_frame_size = value;
+            break;
+        case SettingsParameter::EnablePush:
+        case SettingsParameter::MaxHeaderListSize:
+        default:
+            break;
+        }
+    }
+
+    m_has_received_settings = true;
+    TRY(send_frame(FrameType::Settings, flag_ack, 0, {}));
+
+    // More streams may be allowed now, or bigger windows.
+    start_queued_streams();
+    return {};
+}
+
+Http2Connection::ProtocolResult Http2Connection::process_go_away(ReadonlyBytes payload)
+{
+    if (payload.size() < 8)
+        return ProtocolError { ErrorCode::FrameSizeError, "GOAWAY too short"sv };
+    auto last_stream_id = read_u32(payload) & max_stream_id;
+    auto error_code = read_u32(payload.slice(4));
+    if (error_code != to_underlying(ErrorCode::NoError))
+        dbgln("Http2Connection: The server is going away with error {}: {}", error_code, StringView { payload.slice(8) });
+
+    m_is_going_away = true;
+
+    // Streams above the last one the server processed never will be.
+    Vector<u32> refused_stream_ids;
+    for (auto& it : m_streams) {
+        if (it.key > last_stream_id)
+            refused_stream_ids.append(it.key);
+    }
+    for (auto stream_id : refused_stream_ids)
+        finish_stream(stream_id, StreamResult::Refused);
+
+    did_finish_a_stream();
+    return {};
+}
+
+Http2Connection::ProtocolResult Http2Connection::process_window_update(FrameHeader const& header, ReadonlyBytes payload)
+{
+    if (payload.size() != 4)
+        return ProtocolError { ErrorCode::FrameSizeError, "WINDOW_UPDATE of the wrong size"sv };
+    auto increment = read_u32(payload) & 0x7fffffff;
+
+    if (header.stream_id == 0) {
+        if (increment == 0)
+            return ProtocolError { ErrorCode::ProtocolError, "WINDOW_UPDATE without an increment"sv };
+        m_connection_send_window += increment;
+        if (m_connection_send_window > max_window_size)
+            return ProtocolError { ErrorCode::FlowControlError, "Connection window too large"sv };
+        return send_request_bodies();
+    }
+
+    auto it = m_streams.find(header.stream_id);
+    if (it == m_streams.end())
+        return {};
+    auto& stream = *it->value;
+    if (increment == 0 || stream.send_window + increment > max_window_size) {
+        send_rst_stream(stream.id, increment == 0 ? ErrorCode::ProtocolError : ErrorCode::FlowControlError);
+        finish_stream(stream.id, StreamResult::Failed);
+        return {};
+    }
+    stream.send_window += increment;
+    return send_request_bodies();
+}
+
+void Http2Connection::call_on_finish(Stream& stream, StreamResult result)
+{
+    if (!stream.callbacks.on_finish)
+        return;
+    Core::deferred_invoke([on_finish = move(stream.callbacks.on_finish), result] {
+        on_finish(result);
+    });
+}
+
+void Http2Connection::finish_stream(u32 stream_id, StreamResult result)
+{
+    auto stream = m_streams.take(stream_id);
+    if (!stream.has_value())
+        return;
+
+    // The server answered before it had all of the request body, so the rest of it isn't wanted.
+    if (result == StreamResult::Complete && !(*stream)->has_sent_end_stream)
+        send_rst_stream(stream_id, ErrorCode::NoError);
+
+    if (result == StreamResult::Complete && !(*stream)->content_encoding.is_null()) {
+        auto decoded = decode_content((*stream)->encoded_body, (*stream)->content_encoding);
+        if (!decoded.has_value()) {
+            dbgln("Http2Connection: Failed to decode a response with Content-Encoding: {}", (*stream)->content_encoding);
+            result = StreamResult::Failed;
+        } else if ((*stream)->callbacks.on_data_received) {
+            (*stream)->callbacks.on_data_received(decoded->bytes());
+        }
+    }
+
+    call_on_finish(**stream, result);
+    did_finish_a_stream();
+}
+
+void Http2Connection::did_finish_a_stream()
+{
+    if (m_streams.is_empty())
+        m_idle_timer.start();
+
+    start_queued_streams();
+    if (m_is_going_away && !has_streams())
+        close();
+}
+
+void Http2Connection::close()
+{
+    send_go_away(ErrorCode::NoError);
+    close_socket();
+}
+
+void Http2Connection::fail_connection(ProtocolError error)
+{
+    dbgln("Http2Connection: {}", error.reason);
+    send_go_away(error.code);
+    close_socket();
+}
+
+void Http2Connection::send_go_away(ErrorCode error_code)
+{
+    if (!m_socket->is_open())
+        return;
+    Vector<u8> payload;
+    // The last stream we accepted from the server, which never starts any.
+    append_u32(payload, 0);
+    append_u32(payload, to_underlying(error_code));
+    (void)send_frame(FrameType::GoAway, 0, 0, payload.span());
+}
+
+void Http2Connection::close_socket()
+{
+    m_is_going_away = true;
+    if (!m_socket->is_open())
+        return;
+    m_socket->on_ready_to_read = nullptr;
+    m_socket->close();
+    m_receive_buffer.clear();
+    m_continued_stream_id.clear();
+
+    auto streams = move(m_streams);
+    for (auto& it : streams)
+        call_on_finish(*it.value, StreamResult::Failed);
+
+    // These were never sent.
+    auto queued_streams = move(m_queued_streams);
+    for (auto& stream : queued_streams)
+        call_on_finish(*stream, StreamResult::Refused);
+}
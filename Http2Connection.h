@@ -0,0 +1,178 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#define AK_DONT_REPLACE_STD
+
+#include "Hpack.h"
+#include <AK/Function.h>
+#include <AK/HashMap.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/RefCounted.h>
+#include <AK/URL.h>
+#include <AK/Weakable.h>
+#include <LibCore/ElapsedTimer.h>
+#include <LibCore/Stream.h>
+#include <LibHTTP/HttpRequest.h>
+
+// An HTTP/2 connection (RFC 9113) over cleartext TCP, which many requests to one origin share as concurrent streams.
+// There's no upgrade from HTTP/1.1 and no TLS: the client has to know that the server speaks HTTP/2 ("prior knowledge").
+//
+// The socket is blocking. Reads only happen when it's readable, and writes are bounded by the server's flow control
+// windows, so they only block for as long as the kernel needs to make room in its send buffer.
+class Http2Connection
+    : public RefCounted<Http2Connection>
+    , public Weakable<Http2Connection> {
+public:
+    enum class StreamResult {
+        Complete,
+        // The server never processed the request (REFUSED_STREAM, or above the last stream ID of a GOAWAY),
+        // so it can be sent again, even if it isn't idempotent.
+        Refused,
+        Failed,
+    };
+
+    struct StreamCallbacks {
+        Function<void(HashMap<String, String, CaseInsensitiveStringTraits> const& response_headers, u32 status_code)> on_headers_received;
+        // The response body, after content decoding.
+        Function<void(ReadonlyBytes)> on_data_received;
+        // Called at most once, from the event loop rather than from within any of our functions.
+        // Not called for a cancelled stream.
+        Function<void(StreamResult)> on_finish;
+    };
+
+    using StreamToken = u64;
+
+    static ErrorOr<NonnullRefPtr<Http2Connection>> connect(AK::URL const&, u16 default_port);
+
+    ~Http2Connection();
+
+    // Streams beyond the server's SETTINGS_MAX_CONCURRENT_STREAMS wait until earlier ones are done.
+    StreamToken start_stream(HTTP::HttpRequest const&, StreamCallbacks);
+    void cancel_stream(StreamToken);
+
+    // False once either side is shutting the connection down. Streams already started still run to completion.
+    bool can_start_streams() const { return m_socket->is_open() && !m_is_going_away; }
+    bool has_streams() const { return !m_streams.is_empty() || !m_queued_streams.is_empty(); }
+    bool is_idle_for(int ms) const { return !has_streams() && m_idle_timer.elapsed() >= ms; }
+
+    // Sends GOAWAY and closes the connection. Streams that are still running fail.
+    void close();
+
+private:
+    enum class FrameType : u8 {
+        Data = 0x0,
+        Headers = 0x1,
+        Priority = 0x2,
+        RstStream = 0x3,
+        Settings = 0x4,
+        PushPromise = 0x5,
+        Ping = 0x6,
+        GoAway = 0x7,
+        WindowUpdate = 0x8,
+        Continuation = 0x9,
+    };
+
+    enum class ErrorCode : u32 {
+        NoError = 0x0,
+        ProtocolError = 0x1,
+        InternalError = 0x2,
+        FlowControlError = 0x3,
+        StreamClosed = 0x5,
+        FrameSizeError = 0x6,
+        RefusedStream = 0x7,
+        Cancel = 0x8,
+        CompressionError = 0x9,
+    };
+
+    // Anything that leaves the connection in a state we can't recover from. It's reported to the server in a GOAWAY.
+    struct ProtocolError {
+        ErrorCode code;
+        StringView reason;
+    };
+    using ProtocolResult = ErrorOr<void, ProtocolError>;
+
+    struct FrameHeader {
+        size_t length { 0 };
+        FrameType type { FrameType::Data };
+        u8 flags { 0 };
+        u32 stream_id { 0 };
+    };
+
+    struct Stream {
+        StreamToken token { 0 };
+        u32 id { 0 };
+        u8 weight { 16 };
+        // Encoded only when the stream starts, since the encoder's table depends on the order header blocks are sent in.
+        Vector<HpackHeader> request_headers;
+        Vector<u8> request_body;
+        size_t request_body_offset { 0 };
+        bool has_sent_end_stream { false };
+        i64 send_window { 0 };
+        i64 receive_window { 0 };
+        size_t received_since_window_update { 0 };
+        bool has_final_response { false };
+        // Compressed bodies are decoded in one go once they're complete, as HTTP::Job does.
+        String content_encoding;
+        Vector<u8> encoded_body;
+        StreamCallbacks callbacks;
+    };
+
+    explicit Http2Connection(NonnullOwnPtr<Core::Stream::TCPSocket>);
+
+    ProtocolResult send_preface();
+    ProtocolResult write(ReadonlyBytes);
+    ProtocolResult send_frame(FrameType, u8 flags, u32 stream_id, ReadonlyBytes payload);
+    ProtocolResult send_headers(Stream&);
+    ProtocolResult send_request_bodies();
+    ProtocolResult send_window_update(u32 stream_id, u32 increment);
+    void send_rst_stream(u32 stream_id, ErrorCode);
+    void send_go_away(ErrorCode);
+    void start_queued_streams();
+
+    void did_become_readable();
+    ProtocolResult process_frames();
+    ProtocolResult process_frame(FrameHeader const&, ReadonlyBytes payload);
+    ProtocolResult process_data(FrameHeader const&, ReadonlyBytes payload);
+    ProtocolResult process_header_block(u32 stream_id, bool end_stream, ReadonlyBytes header_block);
+    ProtocolResult process_settings(FrameHeader const&, ReadonlyBytes payload);
+    ProtocolResult process_go_away(ReadonlyBytes payload);
+    ProtocolResult process_window_update(FrameHeader const&, ReadonlyBytes payload);
+
+    void finish_stream(u32 stream_id, StreamResult);
+    void call_on_finish(Stream&, StreamResult);
+    void did_finish_a_stream();
+    void fail_connection(ProtocolError);
+    void close_socket();
+
+    NonnullOwnPtr<Core::Stream::TCPSocket> m_socket;
+    Vector<u8> m_receive_buffer;
+    HpackEncoder m_hpack_encoder;
+    HpackDecoder m_hpack_decoder;
+
+    HashMap<u32, NonnullOwnPtr<Stream>> m_streams;
+    Vector<NonnullOwnPtr<Stream>> m_queued_streams;
+    StreamToken m_next_stream_token { 1 };
+    u32 m_next_stream_id { 1 };
+    Core::ElapsedTimer m_idle_timer;
+
+    // A header block split over HEADERS and CONTINUATION frames, which arrive back to back.
+    Optional<u32> m_continued_stream_id;
+    bool m_continued_stream_ends { false };
+    Vector<u8> m_continued_header_block;
+
+    bool m_has_received_settings { false };
+    bool m_is_going_away { false };
+
+    // The server's settings, with the defaults from RFC 9113, 6.5.2, until its SETTINGS frame arrives. There's no default
+    // stream limit, but servers are asked to allow at least 100, so we don't start more before we know.
+    size_t m_max_concurrent_streams { 100 };
+    i64 m_initial_send_window { 65535 };
+    size_t m_max_send_frame_size { 16384 };
+
+    i64 m_connection_send_window { 65535 };
+    i64 m_connection_receive_window { 65535 };
+    size_t m_received_since_connection_window_update { 0 };
+};
@@ -0,0 +1,172 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#define AK_DONT_REPLACE_STD
+
+#include "MemoryPressureMonitor.h"
+#include <AK/Format.h>
+#include <AK/Optional.h>
+#include <LibCore/System.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#ifdef __GLIBC__
+#    include <malloc.h>
+#endif
+
+static constexpr int poll_interval_ms = 1000;
+
+// While pressure persists, reclaim again at most this often.
+static constexpr int reclaim_interval_ms = 10000;
+
+// PSI "avg10" percentages at which we consider ourselves under pressure.
+static constexpr double moderate_some_avg10 = 10.0;
+static constexpr double critical_full_avg10 = 10.0;
+
+static StringView level_name(MemoryPressureLevel level)
+{
+    switch (level) {
+    case MemoryPressureLevel::None:
+        return "none"sv;
+    case MemoryPressureLevel::Moderate:
+        return "moderate"sv;
+    case MemoryPressureLevel::Critical:
+        return "critical"sv;
+    }
+    VERIFY_NOT_REACHED();
+}
+
+static Optional<String> read_small_file(char const* path)
+{
+    auto fd_or_error = Core::System::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd_or_error.is_error())
+        return {};
+    char buffer[512];
+    auto nread_or_error = Core::System::read(fd_or_error.value(), { buffer, sizeof(buffer) - 1 });
+    (void)Core::System::close(fd_or_error.value());
+    if (nread_or_error.is_error())
+        return {};
+    return String { buffer, nread_or_error.value() };
+}
+
+static size_t current_rss()
+{
+    // /proc/self/statm: total program size, then resident set size, both in pages.
+    auto statm = read_small_file("/proc/self/statm");
+    if (!statm.has_value())
+        return 0;
+    auto parts = statm->split_view(' ');
+    if (parts.size() < 2)
+        return 0;
+    return parts[1].to_uint<size_t>().value_or(0) * sysconf(_SC_PAGESIZE);
+}
+
+// Lines look like "some avg10=0.00 avg60=0.00 avg300=0.00 total=0", followed by the same for "full".
+static Optional<double> pressure_avg10(String const& pressure, StringView kind)
+{
+    for (auto line : pressure.split_view('\n')) {
+        if (!line.starts_with(kind))
+            continue;
+        auto avg10_start = line.find("avg10="sv);
+        if (!avg10_start.has_value())
+            return {};
+        auto value = line.substring_view(*avg10_start + 6);
+        if (auto end = value.find(' '); end.has_value())
+            value = value.substring_view(0, *end);
+        return strtod(String { value }.characters(), nullptr);
+    }
+    return {};
+}
+
+MemoryPressureMonitor& MemoryPressureMonitor::the()
+{
+    static MemoryPressureMonitor s_the;
+    return s_the;
+}
+
+void MemoryPressureMonitor::start()
+{
+    m_timer = Core::Timer::create_repeating(poll_interval_ms, [this] {
+        check();
+    });
+    m_timer->start();
+}
+
+void MemoryPressureMonitor::reset_after_fork()
+{
+    m_reclaimers.clear();
+    m_level = MemoryPressureLevel::None;
+    m_last_reclaim_timer = {};
+    start();
+}
+
+void MemoryPressureMonitor::register_reclaimer(String name, MemoryPressureLevel level, Function<size_t()> reclaim)
+{
+    m_reclaimers.append({ move(name), level, move(reclaim) });
+}
+
+MemoryPressureLevel MemoryPressureMonitor::current_level() const
+{
+    auto level = MemoryPressureLevel::None;
+
+    if (auto pressure = read_small_file("/proc/pressure/memory"); pressure.has_value()) {
+        if (pressure_avg10(*pressure, "full"sv).value_or(0) >= critical_full_avg10)
+            return MemoryPressureLevel::Critical;
+        if (pressure_avg10(*pressure, "some"sv).value_or(0) >= moderate_some_avg10)
+            level = MemoryPressureLevel::Moderate;
+    }
+
+    if (m_rss_limit) {
+        auto rss = current_rss();
+        if (rss >= m_rss_limit)
+            return MemoryPressureLevel::Critical;
+        if (rss >= m_rss_limit / 10 * 8)
+            level = MemoryPressureLevel::Moderate;
+    }
+
+    return level;
+}
+
+void MemoryPressureMonitor::check()
+{
+    auto level = current_level();
+    if (level != m_level)
+        dbgln("Memory pressure in {}: {} -> {}", getpid(), level_name(m_level), level_name(level));
+
+    bool got_worse = level > m_level;
+    m_level = level;
+
+    if (level == MemoryPressureLevel::None)
+        return;
+    if (!got_worse && m_last_reclaim_timer.is_valid() && m_last_reclaim_timer.elapsed() < reclaim_interval_ms)
+        return;
+
+    m_last_reclaim_timer.start();
+    reclaim(level);
+}
+
+void MemoryPressureMonitor::reclaim(MemoryPressureLevel level)
+{
+    auto log_reclaimed = [&](StringView name, size_t estimated_bytes, size_t rss_before) {
+        auto rss_after = current_rss();
+        auto rss_reclaimed = rss_before > rss_after ? rss_before - rss_after : 0;
+        dbgln("Memory pressure ({}) in {}: {} reclaimed ~{} KiB, RSS down {} KiB",
+            level_name(level), getpid(), name, estimated_bytes / KiB, rss_reclaimed / KiB);
+    };
+
+    for (auto& reclaimer : m_reclaimers) {
+        if (reclaimer.level > level)
+            continue;
+        auto rss_before = current_rss();
+        auto estimated_bytes = reclaimer.reclaim();
+        log_reclaimed(reclaimer.name, estimated_bytes, rss_before);
+    }
+
+#ifdef __GLIBC__
+    // Hand back whatever the reclaimers just freed to the system.
+    auto rss_before = current_rss();
+    malloc_trim(0);
+    log_reclaimed("malloc_trim"sv, 0, rss_before);
+#endif
+}
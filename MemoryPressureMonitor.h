@@ -0,0 +1,57 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#define AK_DONT_REPLACE_STD
+
+#include <AK/Function.h>
+#include <AK/String.h>
+#include <AK/Vector.h>
+#include <LibCore/ElapsedTimer.h>
+#include <LibCore/Timer.h>
+
+enum class MemoryPressureLevel {
+    None,
+    Moderate,
+    Critical,
+};
+
+// Polls system memory pressure (Linux PSI, /proc/pressure/memory) and our own RSS from the event loop.
+// Under pressure, runs the registered reclaimers for that level, followed by malloc_trim(), and logs what each one freed.
+class MemoryPressureMonitor {
+public:
+    static MemoryPressureMonitor& the();
+
+    // RSS above 80% of the limit counts as moderate pressure, above the limit as critical. 0 means no limit.
+    void set_rss_limit(size_t bytes) { m_rss_limit = bytes; }
+
+    void start();
+
+    // Forgets the reclaimers inherited from the parent process and starts polling afresh.
+    void reset_after_fork();
+
+    // The reclaimer runs whenever pressure is at least the given level. It returns an estimate of the bytes it freed,
+    // or 0 if it can't tell, in which case only the change in RSS gets logged.
+    void register_reclaimer(String name, MemoryPressureLevel, Function<size_t()> reclaim);
+
+private:
+    MemoryPressureMonitor() = default;
+
+    struct Reclaimer {
+        String name;
+        MemoryPressureLevel level { MemoryPressureLevel::Moderate };
+        Function<size_t()> reclaim;
+    };
+
+    void check();
+    MemoryPressureLevel current_level() const;
+    void reclaim(MemoryPressureLevel);
+
+    Vector<Reclaimer> m_reclaimers;
+    RefPtr<Core::Timer> m_timer;
+    MemoryPressureLevel m_level { MemoryPressureLevel::None };
+    Core::ElapsedTimer m_last_reclaim_timer;
+    size_t m_rss_limit { 0 };
+};
@@ -0,0 +1,252 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#define AK_DONT_REPLACE_STD
+
+#include "PreloadScanner.h"
+#include <AK/Array.h>
+#include <AK/CharacterTypes.h>
+#include <AK/GenericLexer.h>
+#include <AK/StringBuilder.h>
+
+static constexpr Array raw_text_tag_names { "script"sv, "style"sv, "textarea"sv, "title"sv };
+
+// Returns where the end tag for the given element starts, or nothing if it isn't within the input yet.
+static Optional<size_t> find_end_tag(StringView input, StringView tag_name)
+{
+    size_t offset = 0;
+    while (true) {
+        auto index = input.find("</"sv, offset);
+        if (!index.has_value())
+            return {};
+        auto name_start = *index + 2;
+        if (name_start + tag_name.length() > input.length())
+            return {};
+        if (input.substring_view(name_start, tag_name.length()).equals_ignoring_case(tag_name))
+            return *index;
+        offset = name_start;
+    }
+}
+
+// Decodes the character references that turn up in URLs: the few named ones that matter, and numeric ones.
+// Anything else is left as it is, which at worst means we guess a URL the page won't actually load.
+static String decode_character_references(StringView value)
+{
+    if (!value.contains('&'))
+        return value.to_string();
+
+    static constexpr Array<Array<StringView, 2>, 5> named_references { {
+        { "amp;"sv, "&"sv },
+        { "lt;"sv, "<"sv },
+        { "gt;"sv, ">"sv },
+        { "quot;"sv, "\""sv },
+        { "apos;"sv, "'"sv },
+    } };
+
+    StringBuilder builder;
+    GenericLexer lexer { value };
+    while (!lexer.is_eof()) {
+        builder.append(lexer.consume_until('&'));
+        if (!lexer.consume_specific('&'))
+            break;
+
+        if (lexer.consume_specific('#')) {
+            bool is_hex = lexer.consume_specific('x') || lexer.consume_specific('X');
+            auto digits = lexer.consume_while(is_hex ? is_ascii_hex_digit : is_ascii_digit);
+            if (digits.is_empty()) {
+                builder.append(is_hex ? "&#x"sv : "&#"sv);
+                continue;
+            }
+            // The semicolon is optional, as in the real tokenizer.
+            lexer.consume_specific(';');
+
+            u32 code_point = 0;
+            for (auto digit : digits) {
+                code_point = code_point * (is_hex ? 16 : 10) + parse_ascii_hex_digit(digit);
+                if (code_point > 0x10FFFF)
+                    break;
+            }
+            if (code_point == 0 || code_point > 0x10FFFF || (code_point >= 0xD800 && code_point <= 0xDFFF))
+                code_point = 0xFFFD;
+            builder.append_code_point(code_point);
+            continue;
+        }
+
+        bool was_decoded = false;
+        for (auto& reference : named_references) {
+            if (lexer.consume_specific(reference[0])) {
+                builder.append(reference[1]);
+                was_decoded = true;
+                break;
+            }
+        }
+        if (!was_decoded)
+            builder.append('&');
+    }
+    return builder.to_string();
+}
+
+PreloadScanner::PreloadScanner(AK::URL document_url)
+    : m_document_url(move(document_url))
+    , m_base_url(m_document_url)
+{
+}
+
+Vector<AK::URL> PreloadScanner::scan(ReadonlyBytes document_so_far)
+{
+    Vector<AK::URL> urls;
+    StringView input { document_so_far };
+
+    while (m_offset < input.length()) {
+        auto remaining = input.substring_view(m_offset);
+
+        if (!m_raw_text_tag_name.is_null()) {
+            auto end_tag = find_end_tag(remaining, m_raw_text_tag_name);
+            if (!end_tag.has_value()) {
+                // Keep just enough to spot an end tag that's cut off, so long inline scripts aren't scanned over and over.
+                auto keep = m_raw_text_tag_name.length() + 2;
+                if (remaining.length() > keep)
+                    m_offset = input.length() - keep;
+                break;
+            }
+            m_offset += *end_tag;
+            m_raw_text_tag_name = {};
+            continue;
+        }
+
+        auto tag_start = remaining.find('<');
+        if (!tag_start.has_value()) {
+            m_offset = input.length();
+            break;
+        }
+        m_offset += *tag_start;
+        remaining = input.substring_view(m_offset);
+
+        if (remaining.length() < 2)
+            break;
+
+        if (remaining.starts_with("<!--"sv)) {
+            auto comment_end = remaining.find("-->"sv, 4);
+            if (!comment_end.has_value())
+                break;
+            m_offset += *comment_end + 3;
+            continue;
+        }
+
+        if (remaining[1] == '/' || remaining[1] == '!' || remaining[1] == '?') {
+            auto tag_end = remaining.find('>');
+            if (!tag_end.has_value())
+                break;
+            m_offset += *tag_end + 1;
+            continue;
+        }
+
+        if (!is_ascii_alpha(remaining[1])) {
+            ++m_offset;
+            continue;
+        }
+
+        size_t tag_length = 0;
+        auto tag = parse_start_tag(remaining, tag_length);
+        if (!tag.has_value())
+            break;
+        m_offset += tag_length;
+        did_find_tag(*tag, urls);
+    }
+
+    return urls;
+}
+
+Optional<PreloadScanner::Tag> PreloadScanner::parse_start_tag(StringView input, size_t& length)
+{
+    GenericLexer lexer { input };
+    lexer.ignore(); // '<'
+
+    Tag tag;
+    tag.name = lexer.consume_while(is_ascii_alphanumeric).to_lowercase_string();
+
+    while (true) {
+        lexer.ignore_while([](char c) { return is_ascii_space(c) || c == '/'; });
+        if (lexer.is_eof())
+            return {};
+        if (lexer.consume_specific('>')) {
+            length = lexer.tell();
+            return tag;
+        }
+
+        auto name = lexer.consume_until([](char c) { return is_ascii_space(c) || c == '=' || c == '>' || c == '/'; });
+        lexer.ignore_while(is_ascii_space);
+        if (lexer.is_eof())
+            return {};
+
+        StringView value;
+        if (lexer.consume_specific('=')) {
+            lexer.ignore_while(is_ascii_space);
+            if (lexer.is_eof())
+                return {};
+            if (lexer.next_is('"') || lexer.next_is('\'')) {
+                auto quote = lexer.consume();
+                value = lexer.consume_until(quote);
+                if (lexer.is_eof())
+                    return {};
+                lexer.ignore();
+            } else {
+                value = lexer.consume_until([](char c) { return is_ascii_space(c) || c == '>'; });
+            }
+        }
+
+        // Like the real tokenizer, the first occurrence of an attribute wins.
+        if (auto attribute_name = name.to_lowercase_string(); !name.is_empty() && !tag.attributes.contains(attribute_name))
+            tag.attributes.set(attribute_name, decode_character_references(value));
+    }
+}
+
+void PreloadScanner::did_find_tag(Tag const& tag, Vector<AK::URL>& urls)
+{
+    if (tag.name == "base"sv) {
+        // Only the first <base href> counts, and it applies to everything after it.
+        if (auto href = tag.attributes.get("href"); href.has_value() && !m_has_base_url) {
+            auto base_url = m_document_url.complete_url(*href);
+            if (base_url.is_valid())
+                m_base_url = move(base_url);
+            m_has_base_url = true;
+        }
+    } else if (tag.name == "link"sv) {
+        auto rel = tag.attributes.get("rel");
+        auto href = tag.attributes.get("href");
+        if (rel.has_value() && href.has_value()) {
+            for (auto type : rel->split_view(' ')) {
+                if (type.equals_ignoring_case("stylesheet"sv) || type.equals_ignoring_case("preload"sv)) {
+                    did_find_url(*href, urls);
+                    break;
+                }
+            }
+        }
+    } else if (tag.name == "script"sv || tag.name == "img"sv) {
+        if (auto src = tag.attributes.get("src"); src.has_value())
+            did_find_url(*src, urls);
+    }
+
+    for (auto raw_text_tag_name : raw_text_tag_names) {
+        if (tag.name == raw_text_tag_name) {
+            m_raw_text_tag_name = tag.name;
+            break;
+        }
+    }
+}
+
+void PreloadScanner::did_find_url(StringView value, Vector<AK::URL>& urls)
+{
+    auto url = m_base_url.complete_url(value.trim_whitespace());
+    if (!url.is_valid())
+        return;
+    if (!url.protocol().equals_ignoring_case("http"sv) && !url.protocol().equals_ignoring_case("https"sv))
+        return;
+
+    // The fragment doesn't change what gets loaded.
+    url.set_fragment({});
+    if (m_seen_urls.set(url.to_string()) != HashSetResult::InsertedNewEntry)
+        return;
+    urls.append(move(url));
+}
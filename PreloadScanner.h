@@ -0,0 +1,48 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#define AK_DONT_REPLACE_STD
+
+#include <AK/HashMap.h>
+#include <AK/HashTable.h>
+#include <AK/Optional.h>
+#include <AK/String.h>
+#include <AK/URL.h>
+#include <AK/Vector.h>
+
+// Picks subresource URLs out of an HTML document while it's still arriving, so they can be requested before
+// the document has been parsed: stylesheets, scripts, images and <link rel=preload>.
+// This is a much simplified tokenizer. That's fine, since whatever it finds is only a guess at what the parser will load.
+class PreloadScanner {
+public:
+    explicit PreloadScanner(AK::URL document_url);
+
+    // Scans the part of the document that hasn't been scanned yet and returns the URLs it hasn't returned before.
+    // A tag that's cut off at the end of the data is scanned on the next call.
+    Vector<AK::URL> scan(ReadonlyBytes document_so_far);
+
+private:
+    struct Tag {
+        String name;
+        HashMap<String, String> attributes;
+    };
+
+    // Returns the tag and its length, or nothing if the tag doesn't end within the given input.
+    static Optional<Tag> parse_start_tag(StringView input, size_t& length);
+
+    void did_find_tag(Tag const&, Vector<AK::URL>&);
+    void did_find_url(StringView, Vector<AK::URL>&);
+
+    AK::URL m_document_url;
+    AK::URL m_base_url;
+    bool m_has_base_url { false };
+    size_t m_offset { 0 };
+
+    // While inside <script>, <style> and the like, everything up to the matching end tag is text.
+    String m_raw_text_tag_name;
+
+    HashTable<String> m_seen_urls;
+};
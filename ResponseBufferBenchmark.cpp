@@ -0,0 +1,56 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#define AK_DONT_REPLACE_STD
+
+#include "ResponseBufferBenchmark.h"
+#include "ResponseBufferPool.h"
+#include <AK/Array.h>
+#include <AK/ByteBuffer.h>
+#include <AK/Format.h>
+#include <LibCore/ElapsedTimer.h>
+
+// From a small script up to a large image, on either side of each size class.
+static constexpr Array response_sizes { 2 * KiB, 48 * KiB, 200 * KiB, 900 * KiB, 4 * MiB };
+
+// About what a socket read hands us at a time.
+static constexpr size_t chunk_size = 16 * KiB;
+
+ErrorOr<int> run_response_buffer_benchmark(size_t requests_per_size)
+{
+    if (requests_per_size == 0)
+        return Error::from_string_literal("Expected at least one request");
+
+    auto chunk = TRY(ByteBuffer::create_uninitialized(chunk_size));
+    for (size_t i = 0; i < chunk_size; ++i)
+        chunk[i] = static_cast<u8>(i);
+
+    auto& pool = ResponseBufferPool::the();
+    for (auto response_size : response_sizes) {
+        // Every size starts out with an empty pool, so the numbers don't depend on the order they run in.
+        pool.trim();
+        auto statistics_before = pool.statistics();
+        auto timer = Core::ElapsedTimer::start_new();
+
+        for (size_t i = 0; i < requests_per_size; ++i) {
+            auto stream = TRY(PooledResponseStream::create());
+            for (size_t offset = 0; offset < response_size; offset += chunk_size)
+                TRY(stream->write(chunk.bytes().trim(min(chunk_size, response_size - offset))));
+            if (stream->size() != response_size)
+                return Error::from_string_literal("Response size doesn't match what was written");
+            stream->release_buffer();
+        }
+
+        auto milliseconds = timer.elapsed();
+        auto& statistics = pool.statistics();
+        auto allocations = statistics.allocations - statistics_before.allocations;
+        auto bytes_copied = statistics.bytes_copied - statistics_before.bytes_copied;
+        outln("{} requests of {} bytes in {}ms: {:.2} allocations and {} bytes copied per request",
+            requests_per_size, response_size, milliseconds,
+            static_cast<double>(allocations) / requests_per_size, bytes_copied / requests_per_size);
+    }
+
+    pool.trim();
+    return 0;
+}
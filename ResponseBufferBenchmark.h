@@ -0,0 +1,14 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#define AK_DONT_REPLACE_STD
+
+#include <AK/Error.h>
+
+// Pushes synthetic responses of a few typical sizes through PooledResponseStream, the way a request receives them,
+// and prints the buffer allocations and the bytes copied by growing the buffer per request, for each size.
+// No network is involved. Returns the process exit code.
+ErrorOr<int> run_response_buffer_benchmark(size_t requests_per_size);
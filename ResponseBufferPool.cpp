@@ -0,0 +1,131 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#define AK_DONT_REPLACE_STD
+
+#include "ResponseBufferPool.h"
+#include <AK/Format.h>
+
+static constexpr size_t requests_per_statistics_report = 100;
+
+static Optional<size_t> size_class_index(size_t size)
+{
+    for (size_t i = 0; i < ResponseBufferPool::size_classes.size(); ++i) {
+        if (size <= ResponseBufferPool::size_classes[i])
+            return i;
+    }
+    return {};
+}
+
+ResponseBufferPool& ResponseBufferPool::the()
+{
+    static ResponseBufferPool s_the;
+    return s_the;
+}
+
+ErrorOr<ByteBuffer> ResponseBufferPool::take(size_t minimum_size)
+{
+    auto index = size_class_index(minimum_size);
+    if (!index.has_value()) {
+        // Too big to be worth pooling.
+        ++m_statistics.allocations;
+        return ByteBuffer::create_uninitialized(minimum_size);
+    }
+
+    auto& idle_buffers = m_idle_buffers[*index];
+    if (!idle_buffers.is_empty()) {
+        ++m_statistics.reuses;
+        return idle_buffers.take_last();
+    }
+
+    ++m_statistics.allocations;
+    return ByteBuffer::create_uninitialized(size_classes[*index]);
+}
+
+void ResponseBufferPool::give_back(ByteBuffer&& buffer)
+{
+    for (size_t i = 0; i < size_classes.size(); ++i) {
+        if (buffer.size() != size_classes[i])
+            continue;
+        if (m_idle_buffers[i].size() < max_idle_buffers_per_size_class)
+            m_idle_buffers[i].append(move(buffer));
+        return;
+    }
+}
+
+size_t ResponseBufferPool::trim()
+{
+    size_t freed_bytes = 0;
+    for (size_t i = 0; i < size_classes.size(); ++i) {
+        freed_bytes += m_idle_buffers[i].size() * size_classes[i];
+        m_idle_buffers[i].clear();
+    }
+    return freed_bytes;
+}
+
+void ResponseBufferPool::did_finish_request()
+{
+    ++m_statistics.requests;
+    if (m_statistics.requests % requests_per_statistics_report != 0)
+        return;
+
+    dbgln("ResponseBufferPool: {} requests, {} buffer allocations ({:.2} per request), {} reuses, {} bytes copied ({} per request)",
+        m_statistics.requests,
+        m_statistics.allocations,
+        static_cast<double>(m_statistics.allocations) / m_statistics.requests,
+        m_statistics.reuses,
+        m_statistics.bytes_copied,
+        m_statistics.bytes_copied / m_statistics.requests);
+}
+
+ErrorOr<NonnullOwnPtr<PooledResponseStream>> PooledResponseStream::create()
+{
+    auto buffer = TRY(ResponseBufferPool::the().take(ResponseBufferPool::size_classes.first()));
+    return adopt_nonnull_own_or_enomem(new (nothrow) PooledResponseStream(move(buffer)));
+}
+
+PooledResponseStream::PooledResponseStream(ByteBuffer&& buffer)
+    : m_buffer(move(buffer))
+{
+}
+
+PooledResponseStream::~PooledResponseStream()
+{
+    release_buffer();
+}
+
+void PooledResponseStream::release_buffer()
+{
+    if (m_buffer.is_empty())
+        return;
+    ResponseBufferPool::the().give_back(move(m_buffer));
+    m_buffer = {};
+    m_size = 0;
+}
+
+ErrorOr<Bytes> PooledResponseStream::read(Bytes)
+{
+    return Error::from_errno(EBADF);
+}
+
+ErrorOr<size_t> PooledResponseStream::write(ReadonlyBytes bytes)
+{
+    if (m_size + bytes.size() > m_buffer.size())
+        TRY(grow(m_size + bytes.size()));
+    bytes.copy_to(m_buffer.bytes().slice(m_size));
+    m_size += bytes.size();
+    return bytes.size();
+}
+
+ErrorOr<void> PooledResponseStream::grow(size_t minimum_capacity)
+{
+    auto& pool = ResponseBufferPool::the();
+    // Grow at least twofold, so large responses don't keep copying everything they've received so far.
+    auto new_buffer = TRY(pool.take(max(minimum_capacity, m_buffer.size() * 2)));
+    m_buffer.bytes().trim(m_size).copy_to(new_buffer.bytes());
+    pool.did_copy(m_size);
+    pool.give_back(move(m_buffer));
+    m_buffer = move(new_buffer);
+    return {};
+}
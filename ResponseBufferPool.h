@@ -0,0 +1,76 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#define AK_DONT_REPLACE_STD
+
+#include <AK/Array.h>
+#include <AK/ByteBuffer.h>
+#include <AK/Vector.h>
+#include <LibCore/Stream.h>
+
+// Recycles the buffers that responses are received into, so a request usually costs no allocation at all.
+class ResponseBufferPool {
+public:
+    static constexpr Array<size_t, 3> size_classes { 64 * KiB, 256 * KiB, 1 * MiB };
+    static constexpr size_t max_idle_buffers_per_size_class = 4;
+
+    struct Statistics {
+        size_t requests { 0 };
+        size_t allocations { 0 };
+        size_t reuses { 0 };
+        size_t bytes_copied { 0 };
+    };
+
+    static ResponseBufferPool& the();
+
+    // Returns a buffer of at least the given size, rounded up to the next size class.
+    ErrorOr<ByteBuffer> take(size_t minimum_size);
+    void give_back(ByteBuffer&&);
+
+    // Frees all idle buffers and returns how many bytes that was.
+    size_t trim();
+
+    void did_copy(size_t bytes) { m_statistics.bytes_copied += bytes; }
+    void did_finish_request();
+
+    Statistics const& statistics() const { return m_statistics; }
+
+private:
+    ResponseBufferPool() = default;
+
+    Array<Vector<ByteBuffer>, size_classes.size()> m_idle_buffers;
+    Statistics m_statistics;
+};
+
+// A write-only stream into a pooled buffer. Starts out at the smallest size class and moves up as the response grows.
+// Once the response is complete, the pooled buffer is handed out as a view and goes back to the pool afterwards.
+class PooledResponseStream final : public Core::Stream::Stream {
+public:
+    static ErrorOr<NonnullOwnPtr<PooledResponseStream>> create();
+    virtual ~PooledResponseStream() override;
+
+    ReadonlyBytes bytes() const { return m_buffer.bytes().trim(m_size); }
+    size_t size() const { return m_size; }
+
+    // Returns the buffer to the pool. Any view from bytes() is dead afterwards.
+    void release_buffer();
+
+    // ^Core::Stream::Stream
+    virtual bool is_writable() const override { return true; }
+    virtual ErrorOr<Bytes> read(Bytes) override;
+    virtual ErrorOr<size_t> write(ReadonlyBytes) override;
+    virtual bool is_eof() const override { return true; }
+    virtual bool is_open() const override { return true; }
+    virtual void close() override { }
+
+private:
+    explicit PooledResponseStream(ByteBuffer&&);
+
+    ErrorOr<void> grow(size_t minimum_capacity);
+
+    ByteBuffer m_buffer;
+    size_t m_size { 0 };
+};
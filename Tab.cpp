@@ -0,0 +1,57 @@
+#include "Tab.h"
+#include "WebView.h"
+#include <QMainWindow>
+#include <QStatusBar>
+
+Tab::Tab(QMainWindow* window)
+    : m_window(window)
+{
+    m_layout = new QBoxLayout(QBoxLayout::Direction::TopToBottom, this);
+    m_layout->setSpacing(0);
+    m_layout->setContentsMargins(0, 0, 0, 0);
+
+    m_toolbar = new QToolBar;
+    m_back_action = m_toolbar->addAction("Back");
+    m_back_action->setShortcut(QKeySequence::Back);
+    m_back_action->setEnabled(false);
+    m_forward_action = m_toolbar->addAction("Forward");
+    m_forward_action->setShortcut(QKeySequence::Forward);
+    m_forward_action->setEnabled(false);
+    m_location_edit = new QLineEdit;
+    m_toolbar->addWidget(m_location_edit);
+
+    m_view = new WebView;
+
+    m_layout->addWidget(m_toolbar);
+    m_layout->addWidget(m_view);
+
+    QObject::connect(m_view, &WebView::linkHovered, m_window->statusBar(), &QStatusBar::showMessage);
+    QObject::connect(m_view, &WebView::linkUnhovered, m_window->statusBar(), &QStatusBar::clearMessage);
+
+    QObject::connect(m_view, &WebView::loadStarted, m_location_edit, &QLineEdit::setText);
+    QObject::connect(m_location_edit, &QLineEdit::returnPressed, this, &Tab::location_edit_return_pressed);
+    QObject::connect(m_view, &WebView::title_changed, this, &Tab::page_title_changed);
+
+    QObject::connect(m_back_action, &QAction::triggered, m_view, &WebView::go_back);
+    QObject::connect(m_forward_action, &QAction::triggered, m_view, &WebView::go_forward);
+    QObject::connect(m_view, &WebView::history_state_changed, this, [this](bool can_go_back, bool can_go_forward) {
+        m_back_action->setEnabled(can_go_back);
+        m_forward_action->setEnabled(can_go_forward);
+    });
+}
+
+void Tab::navigate(QString url)
+{
+    view().load(url.toUtf8().data());
+}
+
+void Tab::location_edit_return_pressed()
+{
+    navigate(m_location_edit->text());
+}
+
+void Tab::page_title_changed(QString title)
+{
+    m_title = title;
+    emit title_changed(move(title));
+}
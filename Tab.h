@@ -0,0 +1,38 @@
+#include <QAction>
+#include <QBoxLayout>
+#include <QLineEdit>
+#include <QToolBar>
+#include <QWidget>
+
+#pragma once
+
+class QMainWindow;
+class WebView;
+
+class Tab final : public QWidget {
+    Q_OBJECT
+public:
+    explicit Tab(QMainWindow* window);
+
+    WebView& view() { return *m_view; }
+    QString const& title() const { return m_title; }
+
+    void navigate(QString);
+
+public slots:
+    void location_edit_return_pressed();
+    void page_title_changed(QString);
+
+signals:
+    void title_changed(QString);
+
+private:
+    QBoxLayout* m_layout { nullptr };
+    QToolBar* m_toolbar { nullptr };
+    QAction* m_back_action { nullptr };
+    QAction* m_forward_action { nullptr };
+    QLineEdit* m_location_edit { nullptr };
+    WebView* m_view { nullptr };
+    QMainWindow* m_window { nullptr };
+    QString m_title;
+};
@@ -0,0 +1,134 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#define AK_DONT_REPLACE_STD
+
+#include "WebContentClient.h"
+#include "WebContentSpawner.h"
+#include <LibCore/System.h>
+#include <LibGfx/Bitmap.h>
+#include <signal.h>
+#include <sys/socket.h>
+
+ErrorOr<NonnullRefPtr<WebContentClient>> WebContentClient::spawn()
+{
+    int socket_fds[2];
+    TRY(Core::System::socketpair(AF_LOCAL, SOCK_STREAM | SOCK_CLOEXEC, 0, socket_fds));
+    int fd_passing_socket_fds[2];
+    TRY(Core::System::socketpair(AF_LOCAL, SOCK_STREAM | SOCK_CLOEXEC, 0, fd_passing_socket_fds));
+
+    auto pid_or_error = fork_web_content_process(socket_fds[1], fd_passing_socket_fds[1]);
+
+    // The WebContent process' ends were only needed until the spawner had passed them on.
+    TRY(Core::System::close(socket_fds[1]));
+    TRY(Core::System::close(fd_passing_socket_fds[1]));
+    auto pid = TRY(pid_or_error);
+
+    auto socket = TRY(Core::Stream::LocalSocket::adopt_fd(socket_fds[0]));
+    TRY(socket->set_blocking(false));
+    auto fd_passing_socket = TRY(Core::Stream::LocalSocket::adopt_fd(fd_passing_socket_fds[0]));
+    return adopt_nonnull_ref_or_enomem(new (nothrow) WebContentClient(move(socket), move(fd_passing_socket), pid));
+}
+
+WebContentClient::WebContentClient(NonnullOwnPtr<Core::Stream::LocalSocket> socket, NonnullOwnPtr<Core::Stream::LocalSocket> fd_passing_socket, pid_t pid)
+    : IPC::ConnectionToServer<WebContentClientEndpoint, WebContentServerEndpoint>(*this, move(socket))
+    , m_fd_passing_socket(move(fd_passing_socket))
+    , m_pid(pid)
+{
+}
+
+WebContentClient::~WebContentClient()
+{
+    // The process would exit by itself once it notices the closed connection, but not if it's stuck in a script.
+    // There's nothing in it worth shutting down cleanly for, and the spawner takes care of reaping it.
+    // Once it has exited, the spawner may already have reaped it, and the pid may belong to someone else by now.
+    if (has_exited())
+        return;
+    if (auto result = Core::System::kill(m_pid, SIGKILL); result.is_error())
+        dbgln("Failed to kill WebContent process {}: {}", m_pid, result.error());
+}
+
+// The WebContent process never writes to the fd passing socket, so it only becomes readable once the process is gone.
+bool WebContentClient::has_exited()
+{
+    auto can_read_or_error = m_fd_passing_socket->can_read_without_blocking();
+    return !can_read_or_error.is_error() && can_read_or_error.value();
+}
+
+void WebContentClient::add_backing_store(i32 backing_store_id, Gfx::Bitmap const& bitmap)
+{
+    VERIFY(bitmap.anonymous_buffer().is_valid());
+    if (!is_open())
+        return;
+
+    // The fd goes out first, so it's already waiting on the other end by the time the message is handled.
+    // Without it, the message must not go out at all, so there's nothing left to do but give up on the process.
+    if (auto result = m_fd_passing_socket->send_fd(bitmap.anonymous_buffer().fd()); result.is_error()) {
+        dbgln("Failed to send backing store {} to WebContent process {}: {}", backing_store_id, m_pid, result.error());
+        shutdown();
+        return;
+    }
+    async_add_backing_store(backing_store_id, bitmap.size(), bitmap.anonymous_buffer().size());
+}
+
+void WebContentClient::did_paint(i32 backing_store_id, Gfx::IntRect const& content_rect, u32 paint_time_ms)
+{
+    if (on_did_paint)
+        on_did_paint(backing_store_id, content_rect, paint_time_ms);
+}
+
+void WebContentClient::did_invalidate(Gfx::IntRect const& content_rect)
+{
+    if (on_did_invalidate)
+        on_did_invalidate(content_rect);
+}
+
+void WebContentClient::did_layout(Gfx::IntSize const& content_size)
+{
+    if (on_did_layout)
+        on_did_layout(content_size);
+}
+
+void WebContentClient::did_change_title(String const& title)
+{
+    if (on_title_change)
+        on_title_change(title);
+}
+
+void WebContentClient::did_start_loading(URL const& url)
+{
+    if (on_load_start)
+        on_load_start(url.to_string());
+}
+
+void WebContentClient::did_finish_loading(URL const& url)
+{
+    if (on_load_finish)
+        on_load_finish(url.to_string());
+}
+
+void WebContentClient::did_hover_link(URL const& url)
+{
+    if (on_link_hover)
+        on_link_hover(url.to_string());
+}
+
+void WebContentClient::did_unhover_link()
+{
+    if (on_link_unhover)
+        on_link_unhover();
+}
+
+void WebContentClient::did_change_history_state(bool can_go_back, bool can_go_forward)
+{
+    if (on_history_state_change)
+        on_history_state_change(can_go_back, can_go_forward);
+}
+
+void WebContentClient::die()
+{
+    dbgln("WebContent process {} went away or stopped responding", m_pid);
+    if (on_crash)
+        on_crash();
+}
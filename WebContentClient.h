@@ -0,0 +1,68 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#define AK_DONT_REPLACE_STD
+
+#include <AK/Function.h>
+#include <AK/URL.h>
+#include <LibCore/Stream.h>
+#include <LibGfx/Forward.h>
+#include <LibIPC/ConnectionToServer.h>
+#include <WebContentClientEndpoint.h>
+#include <WebContentServerEndpoint.h>
+#include <sys/types.h>
+
+// The UI process' side of the connection to a WebContent process.
+// File descriptors are passed over a separate socket, so they can never get interleaved with message bytes.
+// The message socket is non-blocking, so a hung WebContent process can never block us. Once it has stopped reading
+// for long enough that a message no longer fits into the socket buffer, LibIPC gives up on the connection.
+class WebContentClient final : public IPC::ConnectionToServer<WebContentClientEndpoint, WebContentServerEndpoint> {
+    C_OBJECT(WebContentClient);
+
+public:
+    // Has the WebContent spawner fork a new WebContent process, and connects to it.
+    static ErrorOr<NonnullRefPtr<WebContentClient>> spawn();
+
+    virtual ~WebContentClient() override;
+
+    pid_t pid() const { return m_pid; }
+
+    // The bitmap must have been created with Gfx::Bitmap::try_create_shareable(), so the WebContent process can map it.
+    void add_backing_store(i32 backing_store_id, Gfx::Bitmap const&);
+
+    Function<void(i32 backing_store_id, Gfx::IntRect const& content_rect, u32 paint_time_ms)> on_did_paint;
+    Function<void(Gfx::IntRect const&)> on_did_invalidate;
+    Function<void(Gfx::IntSize const& content_size)> on_did_layout;
+    Function<void(String const&)> on_title_change;
+    Function<void(String const& url)> on_load_start;
+    Function<void(String const& url)> on_load_finish;
+    Function<void(String const& url)> on_link_hover;
+    Function<void()> on_link_unhover;
+    Function<void(bool can_go_back, bool can_go_forward)> on_history_state_change;
+    Function<void()> on_crash;
+
+private:
+    WebContentClient(NonnullOwnPtr<Core::Stream::LocalSocket>, NonnullOwnPtr<Core::Stream::LocalSocket> fd_passing_socket, pid_t);
+
+    // ^WebContentClientEndpoint
+    virtual void did_paint(i32 backing_store_id, Gfx::IntRect const& content_rect, u32 paint_time_ms) override;
+    virtual void did_invalidate(Gfx::IntRect const&) override;
+    virtual void did_layout(Gfx::IntSize const& content_size) override;
+    virtual void did_change_title(String const&) override;
+    virtual void did_start_loading(URL const&) override;
+    virtual void did_finish_loading(URL const&) override;
+    virtual void did_hover_link(URL const&) override;
+    virtual void did_unhover_link() override;
+    virtual void did_change_history_state(bool can_go_back, bool can_go_forward) override;
+
+    // ^IPC::ConnectionBase
+    virtual void die() override;
+
+    bool has_exited();
+
+    NonnullOwnPtr<Core::Stream::LocalSocket> m_fd_passing_socket;
+    pid_t m_pid { -1 };
+};
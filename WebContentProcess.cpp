@@ -0,0 +1,771 @@
+/*
+ * Copyright (c) 2022, Dex♪ <dexes.ttp@gmail.com>
+ * Copyright (c) 2022, Andreas Kling <kling@serenityos.org>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#define AK_DONT_REPLACE_STD
+
+#include "WebContentProcess.h"
+#include "ConnectionPool.h"
+#include "MemoryPressureMonitor.h"
+#include "ResponseBufferPool.h"
+#include <AK/Format.h>
+#include <AK/HashMap.h>
+#include <AK/NonnullOwnPtr.h>
+#include <LibCore/AnonymousBuffer.h>
+#include <LibCore/ElapsedTimer.h>
+#include <LibCore/EventLoop.h>
+#include <LibCore/System.h>
+#include <LibGfx/Bitmap.h>
+#include <LibGfx/Painter.h>
+#include <LibGfx/Rect.h>
+#include <LibIPC/ConnectionFromClient.h>
+#include <LibWeb/Cookie/ParsedCookie.h>
+#include <LibWeb/DOM/Document.h>
+#include <LibWeb/HTML/BrowsingContext.h>
+#include <LibWeb/Layout/InitialContainingBlock.h>
+#include <LibWeb/Loader/FileRequest.h>
+#include <LibWeb/Loader/ResourceLoader.h>
+#include <LibWeb/Page/Page.h>
+#include <LibWeb/Painting/PaintableBox.h>
+#include <WebContentClientEndpoint.h>
+#include <WebContentServerEndpoint.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+extern Core::AnonymousBuffer s_theme_buffer;
+extern size_t discard_unclaimed_speculative_requests();
+
+static size_t s_back_forward_cache_budget = 64 * MiB;
+
+void set_back_forward_cache_budget(size_t budget)
+{
+    s_back_forward_cache_budget = budget;
+}
+
+class HeadlessBrowserPageClient;
+
+class WebContentConnection final : public IPC::ConnectionFromClient<WebContentClientEndpoint, WebContentServerEndpoint> {
+    C_OBJECT(WebContentConnection);
+
+public:
+    // Both sockets stay blocking. If the UI process falls behind, we wait for it instead of dropping messages.
+    static ErrorOr<NonnullRefPtr<WebContentConnection>> try_create(int socket_fd, int fd_passing_socket_fd)
+    {
+        auto socket = TRY(Core::Stream::LocalSocket::adopt_fd(socket_fd));
+        auto fd_passing_socket = TRY(Core::Stream::LocalSocket::adopt_fd(fd_passing_socket_fd));
+        return adopt_nonnull_ref_or_enomem(new (nothrow) WebContentConnection(move(socket), move(fd_passing_socket)));
+    }
+
+    virtual ~WebContentConnection() override;
+
+    Function<void()> on_disconnect;
+
+    void did_invalidate(Gfx::IntRect const&);
+    void did_layout(Gfx::IntSize const& content_size);
+    void did_change_title(String const&);
+    void did_start_loading(AK::URL const&);
+    void did_finish_loading(AK::URL const&);
+    void did_hover_link(AK::URL const&);
+    void did_unhover_link();
+    void did_click_link(AK::URL const&);
+    void did_cached_page_stay_busy(u64 page_id);
+
+    bool is_active_page_client(HeadlessBrowserPageClient const& page_client) const { return m_page_client.ptr() == &page_client; }
+
+private:
+    // Every navigation gets a history entry. Entries we navigated away from keep their page as long as the
+    // back/forward cache budget allows. Going back or forward to such an entry just makes its page active again.
+    // Cached pages aren't frozen: their timers, loads and layouts keep running, only without telling the UI.
+    // Pages that keep busy in the cache get evicted, see HeadlessBrowserPageClient::did_work_while_cached().
+    struct HistoryEntry {
+        AK::URL url;
+        OwnPtr<HeadlessBrowserPageClient> cached_page_client;
+        size_t estimated_size { 0 };
+        u64 last_used { 0 };
+    };
+
+    struct BackForwardCacheStatistics {
+        size_t hits { 0 };
+        size_t misses { 0 };
+        size_t evictions { 0 };
+    };
+
+    WebContentConnection(NonnullOwnPtr<Core::Stream::LocalSocket>, NonnullOwnPtr<Core::Stream::LocalSocket> fd_passing_socket);
+
+    // ^WebContentServerEndpoint
+    virtual void load_url(URL const&) override;
+    virtual void go_back() override;
+    virtual void go_forward() override;
+    virtual void set_viewport_rect(Gfx::IntRect const&) override;
+    virtual void set_visible(bool) override;
+    virtual void mouse_move(Gfx::IntPoint const&, unsigned buttons, unsigned modifiers) override;
+    virtual void mouse_down(Gfx::IntPoint const&, unsigned button, unsigned modifiers) override;
+    virtual void mouse_up(Gfx::IntPoint const&, unsigned button, unsigned modifiers) override;
+    virtual void add_backing_store(i32 backing_store_id, Gfx::IntSize const&, u64 buffer_size) override;
+    virtual void remove_backing_store(i32 backing_store_id) override;
+    virtual void paint(Gfx::IntRect const& content_rect, i32 backing_store_id) override;
+
+    // ^IPC::ConnectionBase
+    virtual void die() override;
+
+    void create_page_client();
+    void navigate(AK::URL const&);
+    void cache_active_page();
+    void restore_page_for_current_history_entry();
+    void evict_cached_pages_over_budget();
+    size_t evict_all_cached_pages();
+    size_t back_forward_cache_size() const;
+    void did_change_history_state();
+
+    NonnullOwnPtr<Core::Stream::LocalSocket> m_fd_passing_socket;
+    OwnPtr<HeadlessBrowserPageClient> m_page_client;
+    HashMap<i32, NonnullRefPtr<Gfx::Bitmap>> m_backing_stores;
+    Gfx::IntRect m_viewport_rect { 0, 0, 800, 600 };
+    bool m_is_visible { true };
+    bool m_has_invalidation_while_hidden { false };
+
+    Vector<HistoryEntry> m_history;
+    size_t m_current_history_index { 0 };
+    u64 m_history_use_counter { 0 };
+    BackForwardCacheStatistics m_back_forward_cache_statistics;
+};
+
+class HeadlessBrowserPageClient final : public Web::PageClient {
+public:
+    static NonnullOwnPtr<HeadlessBrowserPageClient> create(WebContentConnection& connection)
+    {
+        return adopt_own(*new HeadlessBrowserPageClient(connection));
+    }
+
+    // Unique for the lifetime of the process, unlike the page client's address.
+    u64 id() const { return m_id; }
+
+    Web::Page& page() { return *m_page; }
+    Web::Page const& page() const { return *m_page; }
+
+    Web::Layout::InitialContainingBlock* layout_root()
+    {
+        auto* document = page().top_level_browsing_context().active_document();
+        if (!document)
+            return nullptr;
+        return document->layout_node();
+    }
+
+    void load(AK::URL const& url)
+    {
+        page().load(url);
+    }
+
+    // Pages kept in the back/forward cache still run, but nobody gets to hear about it.
+    bool is_active() const { return m_connection.is_active_page_client(*this); }
+
+    // What a page did while it sat in the back/forward cache, as a stand-in for the CPU and network it cost us.
+    struct BackgroundActivity {
+        size_t invalidations { 0 };
+        size_t layouts { 0 };
+        size_t loads { 0 };
+
+        size_t total() const { return invalidations + layouts + loads; }
+    };
+
+    // A cached page that has done this much is evicted, since it's not going to stop by itself.
+    static constexpr size_t max_background_activity = 200;
+
+    void did_enter_back_forward_cache()
+    {
+        m_background_activity = {};
+        m_cached_timer.start();
+    }
+
+    void log_background_activity(AK::URL const& url, StringView outcome) const
+    {
+        dbgln("WebContent: Cached page {} {} after {}ms in the cache, during which it did {} invalidations, {} layouts and {} loads",
+            url,
+            outcome,
+            m_cached_timer.is_valid() ? m_cached_timer.elapsed() : 0,
+            m_background_activity.invalidations,
+            m_background_activity.layouts,
+            m_background_activity.loads);
+    }
+
+    // A rough guess from the size of the DOM, used for budgeting the back/forward cache.
+    size_t estimated_memory_usage()
+    {
+        static constexpr size_t estimated_bytes_per_dom_node = 2 * KiB;
+
+        auto* document = page().top_level_browsing_context().active_document();
+        if (!document)
+            return 0;
+        size_t node_count = 0;
+        document->for_each_in_inclusive_subtree([&](auto&) {
+            ++node_count;
+            return IterationDecision::Continue;
+        });
+        return node_count * estimated_bytes_per_dom_node;
+    }
+
+    String title() const
+    {
+        auto const* document = page().top_level_browsing_context().active_document();
+        if (!document)
+            return String::empty();
+        return document->title();
+    }
+
+    void paint(Gfx::IntRect const& content_rect, Gfx::Bitmap& target)
+    {
+        Gfx::Painter painter(target);
+
+        if (auto* document = page().top_level_browsing_context().active_document())
+            document->update_layout();
+
+        painter.fill_rect({ {}, content_rect.size() }, palette().base());
+
+        auto* layout_root = this->layout_root();
+        if (!layout_root) {
+            return;
+        }
+
+        Web::PaintContext context(painter, palette(), content_rect.top_left());
+        context.set_should_show_line_box_borders(false);
+        context.set_viewport_rect(content_rect);
+        context.set_has_focus(true);
+        layout_root->paint_all_phases(context);
+    }
+
+    void setup_palette(Core::AnonymousBuffer theme_buffer)
+    {
+        m_palette_impl = Gfx::PaletteImpl::create_with_anonymous_buffer(theme_buffer);
+    }
+
+    void set_viewport_rect(Gfx::IntRect rect)
+    {
+        m_viewport_rect = rect;
+        page().top_level_browsing_context().set_viewport_rect(rect);
+    }
+
+    // ^Web::PageClient
+    virtual Gfx::Palette palette() const override
+    {
+        return Gfx::Palette(*m_palette_impl);
+    }
+
+    virtual Gfx::IntRect screen_rect() const override
+    {
+        // FIXME: Return the actual screen rect.
+        return m_viewport_rect;
+    }
+
+    Gfx::IntRect viewport_rect() const
+    {
+        return m_viewport_rect;
+    }
+
+    virtual Web::CSS::PreferredColorScheme preferred_color_scheme() const override
+    {
+        return m_preferred_color_scheme;
+    }
+
+    virtual void page_did_change_title(String const& title) override
+    {
+        if (is_active())
+            m_connection.did_change_title(title);
+    }
+
+    virtual void page_did_set_document_in_top_level_browsing_context(Web::DOM::Document*) override
+    {
+    }
+
+    virtual void page_did_start_loading(AK::URL const& url) override
+    {
+        if (is_active())
+            m_connection.did_start_loading(url);
+        else
+            did_work_while_cached(m_background_activity.loads);
+    }
+
+    virtual void page_did_finish_loading(AK::URL const& url) override
+    {
+        if (is_active())
+            m_connection.did_finish_loading(url);
+    }
+
+    virtual void page_did_change_selection() override
+    {
+    }
+
+    virtual void page_did_request_cursor_change(Gfx::StandardCursor) override
+    {
+    }
+
+    virtual void page_did_request_context_menu(Gfx::IntPoint const&) override
+    {
+    }
+
+    virtual void page_did_request_link_context_menu(Gfx::IntPoint const&, AK::URL const&, String const&, unsigned) override
+    {
+    }
+
+    virtual void page_did_request_image_context_menu(Gfx::IntPoint const&, AK::URL const&, String const&, unsigned, Gfx::Bitmap const*) override
+    {
+    }
+
+    virtual void page_did_click_link(AK::URL const& url, String const&, unsigned) override
+    {
+        if (is_active())
+            m_connection.did_click_link(url);
+    }
+
+    virtual void page_did_middle_click_link(AK::URL const&, String const&, unsigned) override
+    {
+    }
+
+    virtual void page_did_enter_tooltip_area(Gfx::IntPoint const&, String const&) override
+    {
+    }
+
+    virtual void page_did_leave_tooltip_area() override
+    {
+    }
+
+    virtual void page_did_hover_link(AK::URL const& url) override
+    {
+        if (is_active())
+            m_connection.did_hover_link(url);
+    }
+
+    virtual void page_did_unhover_link() override
+    {
+        if (is_active())
+            m_connection.did_unhover_link();
+    }
+
+    virtual void page_did_invalidate(Gfx::IntRect const& rect) override
+    {
+        if (is_active())
+            m_connection.did_invalidate(rect);
+        else
+            did_work_while_cached(m_background_activity.invalidations);
+    }
+
+    virtual void page_did_change_favicon(Gfx::Bitmap const&) override
+    {
+    }
+
+    virtual void page_did_layout() override
+    {
+        if (!is_active()) {
+            did_work_while_cached(m_background_activity.layouts);
+            return;
+        }
+
+        auto* layout_root = this->layout_root();
+        VERIFY(layout_root);
+        Gfx::IntSize content_size;
+        if (layout_root->paint_box()->has_overflow())
+            content_size = enclosing_int_rect(layout_root->paint_box()->scrollable_overflow_rect().value()).size();
+        else
+            content_size = enclosing_int_rect(layout_root->paint_box()->absolute_rect()).size();
+
+        m_connection.did_layout(content_size);
+    }
+
+    virtual void page_did_request_scroll_into_view(Gfx::IntRect const&) override
+    {
+    }
+
+    virtual void page_did_request_alert(String const&) override
+    {
+    }
+
+    virtual bool page_did_request_confirm(String const&) override
+    {
+        return false;
+    }
+
+    virtual String page_did_request_prompt(String const&, String const&) override
+    {
+        return String::empty();
+    }
+
+    virtual String page_did_request_cookie(AK::URL const&, Web::Cookie::Source) override
+    {
+        return String::empty();
+    }
+
+    virtual void page_did_set_cookie(AK::URL const&, Web::Cookie::ParsedCookie const&, Web::Cookie::Source) override
+    {
+    }
+
+    void request_file(NonnullRefPtr<Web::FileRequest>& request) override
+    {
+        auto const file = Core::System::open(request->path(), O_RDONLY);
+        request->on_file_request_finish(file);
+    }
+
+private:
+    HeadlessBrowserPageClient(WebContentConnection& connection)
+        : m_id(++s_last_id)
+        , m_connection(connection)
+        , m_page(make<Web::Page>(*this))
+    {
+    }
+
+    void did_work_while_cached(size_t& counter)
+    {
+        ++counter;
+        if (m_background_activity.total() == max_background_activity)
+            m_connection.did_cached_page_stay_busy(m_id);
+    }
+
+    static inline u64 s_last_id { 0 };
+
+    u64 m_id { 0 };
+    WebContentConnection& m_connection;
+    NonnullOwnPtr<Web::Page> m_page;
+
+    BackgroundActivity m_background_activity;
+    Core::ElapsedTimer m_cached_timer;
+
+    RefPtr<Gfx::PaletteImpl> m_palette_impl;
+    Gfx::IntRect m_viewport_rect { 0, 0, 800, 600 };
+    Web::CSS::PreferredColorScheme m_preferred_color_scheme { Web::CSS::PreferredColorScheme::Auto };
+};
+
+WebContentConnection::WebContentConnection(NonnullOwnPtr<Core::Stream::LocalSocket> socket, NonnullOwnPtr<Core::Stream::LocalSocket> fd_passing_socket)
+    : IPC::ConnectionFromClient<WebContentClientEndpoint, WebContentServerEndpoint>(*this, move(socket), 1)
+    , m_fd_passing_socket(move(fd_passing_socket))
+{
+    create_page_client();
+
+    auto& memory_pressure_monitor = MemoryPressureMonitor::the();
+    memory_pressure_monitor.register_reclaimer("back/forward cache", MemoryPressureLevel::Moderate, [this] {
+        return evict_all_cached_pages();
+    });
+    // This is where decoded images live, so dropping it releases their frames along with the encoded data.
+    memory_pressure_monitor.register_reclaimer("resource cache", MemoryPressureLevel::Critical, [] {
+        Web::ResourceLoader::the().clear_cache();
+        return 0;
+    });
+    memory_pressure_monitor.register_reclaimer("response buffer pool", MemoryPressureLevel::Moderate, [] {
+        return ResponseBufferPool::the().trim();
+    });
+    memory_pressure_monitor.register_reclaimer("speculative responses", MemoryPressureLevel::Moderate, [] {
+        return discard_unclaimed_speculative_requests();
+    });
+    memory_pressure_monitor.register_reclaimer("idle connections", MemoryPressureLevel::Moderate, [] {
+        ConnectionPool::the().close_idle_connections();
+        return 0;
+    });
+}
+
+WebContentConnection::~WebContentConnection() = default;
+
+void WebContentConnection::load_url(URL const& url)
+{
+    navigate(url);
+}
+
+void WebContentConnection::set_viewport_rect(Gfx::IntRect const& rect)
+{
+    m_viewport_rect = rect;
+    m_page_client->set_viewport_rect(m_viewport_rect);
+}
+
+void WebContentConnection::mouse_move(Gfx::IntPoint const& position, unsigned buttons, unsigned modifiers)
+{
+    m_page_client->page().handle_mousemove(position, buttons, modifiers);
+}
+
+void WebContentConnection::mouse_down(Gfx::IntPoint const& position, unsigned button, unsigned modifiers)
+{
+    m_page_client->page().handle_mousedown(position, button, modifiers);
+}
+
+void WebContentConnection::mouse_up(Gfx::IntPoint const& position, unsigned button, unsigned modifiers)
+{
+    m_page_client->page().handle_mouseup(position, button, modifiers);
+}
+
+void WebContentConnection::add_backing_store(i32 backing_store_id, Gfx::IntSize const& size, u64 buffer_size)
+{
+    // The UI process sends the buffer's fd right before this message.
+    auto bitmap_or_error = [&]() -> ErrorOr<NonnullRefPtr<Gfx::Bitmap>> {
+        auto buffer = TRY(Core::AnonymousBuffer::create_from_anon_fd(TRY(m_fd_passing_socket->receive_fd(O_CLOEXEC)), buffer_size));
+        return Gfx::Bitmap::try_create_with_anonymous_buffer(Gfx::BitmapFormat::BGRx8888, move(buffer), size, 1, {});
+    }();
+    if (bitmap_or_error.is_error()) {
+        dbgln("WebContent: Failed to add backing store {}: {}", backing_store_id, bitmap_or_error.error());
+        did_misbehave("Invalid backing store");
+        return;
+    }
+    m_backing_stores.set(backing_store_id, bitmap_or_error.release_value());
+}
+
+void WebContentConnection::remove_backing_store(i32 backing_store_id)
+{
+    m_backing_stores.remove(backing_store_id);
+}
+
+void WebContentConnection::paint(Gfx::IntRect const& content_rect, i32 backing_store_id)
+{
+    auto paint_timer = Core::ElapsedTimer::start_new();
+
+    // The UI may have discarded the backing store after asking for this paint, or hidden us. It still expects an answer.
+    // A paint skipped while hidden is made up for by an invalidation once we're shown again.
+    if (!m_is_visible)
+        m_has_invalidation_while_hidden = true;
+    else if (auto backing_store = m_backing_stores.get(backing_store_id); backing_store.has_value())
+        m_page_client->paint(content_rect, *backing_store.value());
+
+    async_did_paint(backing_store_id, content_rect, paint_timer.elapsed());
+}
+
+void WebContentConnection::create_page_client()
+{
+    m_page_client = HeadlessBrowserPageClient::create(*this);
+    m_page_client->setup_palette(s_theme_buffer);
+    m_page_client->set_viewport_rect(m_viewport_rect);
+}
+
+void WebContentConnection::navigate(AK::URL const& url)
+{
+    if (!m_history.is_empty()) {
+        cache_active_page();
+        for (size_t i = m_current_history_index + 1; i < m_history.size(); ++i) {
+            if (m_history[i].cached_page_client)
+                ++m_back_forward_cache_statistics.evictions;
+        }
+        m_history.shrink(m_current_history_index + 1);
+        create_page_client();
+    }
+
+    m_history.append({ url, {}, 0, 0 });
+    m_current_history_index = m_history.size() - 1;
+    m_page_client->load(url);
+
+    evict_cached_pages_over_budget();
+    did_change_history_state();
+}
+
+void WebContentConnection::go_back()
+{
+    if (m_history.is_empty() || m_current_history_index == 0)
+        return;
+    cache_active_page();
+    --m_current_history_index;
+    restore_page_for_current_history_entry();
+}
+
+void WebContentConnection::go_forward()
+{
+    if (m_current_history_index + 1 >= m_history.size())
+        return;
+    cache_active_page();
+    ++m_current_history_index;
+    restore_page_for_current_history_entry();
+}
+
+void WebContentConnection::cache_active_page()
+{
+    auto& entry = m_history[m_current_history_index];
+    entry.estimated_size = m_page_client->estimated_memory_usage();
+    entry.last_used = ++m_history_use_counter;
+    entry.cached_page_client = move(m_page_client);
+    entry.cached_page_client->did_enter_back_forward_cache();
+}
+
+void WebContentConnection::did_cached_page_stay_busy(u64 page_id)
+{
+    // We're inside one of the page's own callbacks, so it can't be destroyed right away.
+    // By the time this runs, the page may have been restored or evicted already; then it's no longer in the cache.
+    // It's looked up by ID, as a new page could have been allocated at the same address in the meantime.
+    Core::deferred_invoke([strong_this = NonnullRefPtr(*this), page_id] {
+        for (auto& entry : strong_this->m_history) {
+            if (!entry.cached_page_client || entry.cached_page_client->id() != page_id)
+                continue;
+            entry.cached_page_client->log_background_activity(entry.url, "evicted for staying busy"sv);
+            entry.cached_page_client = nullptr;
+            entry.estimated_size = 0;
+            ++strong_this->m_back_forward_cache_statistics.evictions;
+            return;
+        }
+    });
+}
+
+void WebContentConnection::restore_page_for_current_history_entry()
+{
+    auto& entry = m_history[m_current_history_index];
+    bool is_hit = !entry.cached_page_client.is_null();
+
+    if (is_hit) {
+        ++m_back_forward_cache_statistics.hits;
+        entry.cached_page_client->log_background_activity(entry.url, "restored"sv);
+        m_page_client = move(entry.cached_page_client);
+        entry.estimated_size = 0;
+
+        // Bring the UI up to date with the page we just switched to. Layout may be stale if the viewport changed
+        // while the page was cached; in that case the next paint will relayout and report the new size.
+        m_page_client->set_viewport_rect(m_viewport_rect);
+        did_start_loading(entry.url);
+        did_change_title(m_page_client->title());
+        if (m_page_client->layout_root())
+            m_page_client->page_did_layout();
+        did_invalidate(m_viewport_rect);
+    } else {
+        ++m_back_forward_cache_statistics.misses;
+        create_page_client();
+        m_page_client->load(entry.url);
+    }
+
+    evict_cached_pages_over_budget();
+
+    auto& statistics = m_back_forward_cache_statistics;
+    dbgln("WebContent: Back/forward cache {} for {}. {} hits, {} misses ({}% hit rate), {} evictions, {} KiB cached",
+        is_hit ? "hit" : "miss",
+        entry.url,
+        statistics.hits,
+        statistics.misses,
+        statistics.hits * 100 / (statistics.hits + statistics.misses),
+        statistics.evictions,
+        back_forward_cache_size() / KiB);
+
+    did_change_history_state();
+}
+
+size_t WebContentConnection::back_forward_cache_size() const
+{
+    size_t size = 0;
+    for (auto& entry : m_history) {
+        if (entry.cached_page_client)
+            size += entry.estimated_size;
+    }
+    return size;
+}
+
+void WebContentConnection::evict_cached_pages_over_budget()
+{
+    while (back_forward_cache_size() > s_back_forward_cache_budget) {
+        HistoryEntry* least_recently_used = nullptr;
+        for (auto& entry : m_history) {
+            if (entry.cached_page_client && (!least_recently_used || entry.last_used < least_recently_used->last_used))
+                least_recently_used = &entry;
+        }
+        VERIFY(least_recently_used);
+        least_recently_used->cached_page_client = nullptr;
+        least_recently_used->estimated_size = 0;
+        ++m_back_forward_cache_statistics.evictions;
+    }
+}
+
+size_t WebContentConnection::evict_all_cached_pages()
+{
+    size_t freed_bytes = 0;
+    for (auto& entry : m_history) {
+        if (!entry.cached_page_client)
+            continue;
+        freed_bytes += entry.estimated_size;
+        entry.cached_page_client = nullptr;
+        entry.estimated_size = 0;
+        ++m_back_forward_cache_statistics.evictions;
+    }
+    return freed_bytes;
+}
+
+void WebContentConnection::did_change_history_state()
+{
+    async_did_change_history_state(m_current_history_index > 0, m_current_history_index + 1 < m_history.size());
+}
+
+void WebContentConnection::die()
+{
+    if (on_disconnect)
+        on_disconnect();
+}
+
+void WebContentConnection::set_visible(bool visible)
+{
+    if (m_is_visible == visible)
+        return;
+    m_is_visible = visible;
+    if (m_is_visible && m_has_invalidation_while_hidden) {
+        m_has_invalidation_while_hidden = false;
+        did_invalidate(m_viewport_rect);
+    }
+}
+
+void WebContentConnection::did_invalidate(Gfx::IntRect const& rect)
+{
+    // Nobody is looking, so there's no point in waking up the UI. Whatever changed gets repainted once we're shown.
+    if (!m_is_visible) {
+        m_has_invalidation_while_hidden = true;
+        return;
+    }
+
+    async_did_invalidate(rect);
+}
+
+void WebContentConnection::did_layout(Gfx::IntSize const& content_size)
+{
+    async_did_layout(content_size);
+}
+
+void WebContentConnection::did_change_title(String const& title)
+{
+    async_did_change_title(title);
+}
+
+void WebContentConnection::did_start_loading(AK::URL const& url)
+{
+    async_did_start_loading(url);
+}
+
+void WebContentConnection::did_finish_loading(AK::URL const& url)
+{
+    async_did_finish_loading(url);
+}
+
+void WebContentConnection::did_hover_link(AK::URL const& url)
+{
+    async_did_hover_link(url);
+}
+
+void WebContentConnection::did_unhover_link()
+{
+    async_did_unhover_link();
+}
+
+void WebContentConnection::did_click_link(AK::URL const& url)
+{
+    // We're inside the clicked page's event handling, which must not be cut short by the navigation.
+    Core::deferred_invoke([this, url] {
+        navigate(url);
+    });
+}
+
+void run_web_content_process(int socket_fd, int fd_passing_socket_fd)
+{
+    // We were forked (via the spawner) from the UI process' main thread, so forget about its event loop before creating our own.
+    Core::EventLoop::notify_forked(Core::EventLoop::ForkEvent::Child);
+    Core::EventLoop event_loop;
+
+    MemoryPressureMonitor::the().reset_after_fork();
+
+    auto connection_or_error = WebContentConnection::try_create(socket_fd, fd_passing_socket_fd);
+    if (connection_or_error.is_error()) {
+        warnln("WebContent: Failed to set up connection: {}", connection_or_error.error());
+        _exit(1);
+    }
+    auto connection = connection_or_error.release_value();
+    connection->on_disconnect = [&] {
+        event_loop.quit(0);
+    };
+
+    auto exit_code = event_loop.exec();
+
+    // Leave without running any of the UI process' atexit handlers or static destructors.
+    _exit(exit_code);
+}
@@ -0,0 +1,15 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+
+// Runs a WebContent process on the child ends of the socket pairs created by WebContentClient::spawn().
+// The web engine is inherited already initialized from the WebContent spawner this was forked from.
+[[noreturn]] void run_web_content_process(int socket_fd, int fd_passing_socket_fd);
+
+// How much memory the pages kept for back/forward navigation may use, as estimated from their DOM size.
+// Has to be set before the WebContent process is spawned.
+void set_back_forward_cache_budget(size_t);
@@ -0,0 +1,95 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#define AK_DONT_REPLACE_STD
+
+#include "WebContentSpawner.h"
+#include "WebContentProcess.h"
+#include <AK/Format.h>
+#include <AK/OwnPtr.h>
+#include <LibCore/Stream.h>
+#include <LibCore/System.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static OwnPtr<Core::Stream::LocalSocket> s_spawner_socket;
+
+// Each request is the two fds for the new WebContent process, and the answer is its pid, or -1 if forking failed.
+[[noreturn]] static void run_spawner(int socket_fd)
+{
+    auto socket_or_error = Core::Stream::LocalSocket::adopt_fd(socket_fd);
+    if (socket_or_error.is_error())
+        _exit(1);
+    auto socket = socket_or_error.release_value();
+
+    // Children are never waited for, so let the kernel reap them.
+    if (Core::System::signal(SIGCHLD, SIG_IGN).is_error())
+        _exit(1);
+
+    for (;;) {
+        // Failing to receive means the UI process has gone away.
+        auto content_socket_fd_or_error = socket->receive_fd(O_CLOEXEC);
+        if (content_socket_fd_or_error.is_error())
+            _exit(0);
+        auto content_fd_passing_socket_fd_or_error = socket->receive_fd(O_CLOEXEC);
+        if (content_fd_passing_socket_fd_or_error.is_error())
+            _exit(0);
+        auto content_socket_fd = content_socket_fd_or_error.value();
+        auto content_fd_passing_socket_fd = content_fd_passing_socket_fd_or_error.value();
+
+        auto pid_or_error = Core::System::fork();
+        if (!pid_or_error.is_error() && pid_or_error.value() == 0) {
+            socket->close();
+            (void)Core::System::signal(SIGCHLD, SIG_DFL);
+            run_web_content_process(content_socket_fd, content_fd_passing_socket_fd);
+        }
+
+        (void)Core::System::close(content_socket_fd);
+        (void)Core::System::close(content_fd_passing_socket_fd);
+
+        pid_t pid = -1;
+        if (pid_or_error.is_error())
+            warnln("WebContent spawner: Failed to fork: {}", pid_or_error.error());
+        else
+            pid = pid_or_error.value();
+        if (!socket->write_or_error({ &pid, sizeof(pid) }))
+            _exit(0);
+    }
+}
+
+ErrorOr<void> start_web_content_spawner()
+{
+    VERIFY(!s_spawner_socket);
+
+    int socket_fds[2];
+    TRY(Core::System::socketpair(AF_LOCAL, SOCK_STREAM | SOCK_CLOEXEC, 0, socket_fds));
+
+    auto pid = TRY(Core::System::fork());
+    if (pid == 0) {
+        (void)Core::System::close(socket_fds[0]);
+        run_spawner(socket_fds[1]);
+    }
+
+    TRY(Core::System::close(socket_fds[1]));
+    s_spawner_socket = TRY(Core::Stream::LocalSocket::adopt_fd(socket_fds[0]));
+    return {};
+}
+
+ErrorOr<pid_t> fork_web_content_process(int socket_fd, int fd_passing_socket_fd)
+{
+    if (!s_spawner_socket)
+        return Error::from_string_literal("WebContent spawner isn't running");
+
+    // Forking is quick, so waiting for the answer doesn't hold up the UI for long.
+    TRY(s_spawner_socket->send_fd(socket_fd));
+    TRY(s_spawner_socket->send_fd(fd_passing_socket_fd));
+    pid_t pid = -1;
+    if (!s_spawner_socket->read_or_error({ &pid, sizeof(pid) }))
+        return Error::from_string_literal("WebContent spawner has gone away");
+    if (pid < 0)
+        return Error::from_string_literal("WebContent spawner failed to fork");
+    return pid;
+}
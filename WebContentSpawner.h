@@ -0,0 +1,17 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Error.h>
+#include <sys/types.h>
+
+// WebContent processes are forked from a helper process, which is forked from the UI process before Qt is set up and
+// before any tab exists. That way a WebContent process inherits the initialized web engine, but neither the display
+// connection nor another tab's connection or backing stores.
+ErrorOr<void> start_web_content_spawner();
+
+// Has the helper fork a WebContent process that runs on the given socket fds. Our copies of the fds stay open.
+// The helper reaps its children, so there's no need to wait for the process once it's gone.
+ErrorOr<pid_t> fork_web_content_process(int socket_fd, int fd_passing_socket_fd);
@@ -0,0 +1,83 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#define AK_DONT_REPLACE_STD
+
+#include "WebSocketEchoBenchmark.h"
+#include <AK/ByteBuffer.h>
+#include <AK/Format.h>
+#include <LibCore/ElapsedTimer.h>
+#include <LibCore/EventLoop.h>
+#include <LibWeb/WebSockets/WebSocket.h>
+
+// Enough to keep the connection busy without relying on how much a send may queue up.
+static constexpr size_t max_messages_in_flight = 16;
+
+ErrorOr<int> run_websocket_echo_benchmark(AK::URL const& url, size_t message_count, size_t message_size)
+{
+    if (!url.is_valid() || (url.protocol() != "ws"sv && url.protocol() != "wss"sv))
+        return Error::from_string_literal("Expected a ws:// or wss:// URL");
+    if (message_count == 0)
+        return Error::from_string_literal("Expected at least one message");
+
+    auto payload = TRY(ByteBuffer::create_uninitialized(message_size));
+    for (size_t i = 0; i < message_size; ++i)
+        payload[i] = static_cast<u8>(i);
+
+    Core::EventLoop event_loop;
+    auto socket = Web::WebSockets::WebSocketClientManager::the().connect(url, "null");
+    if (!socket)
+        return Error::from_string_literal("Could not create a WebSocket");
+
+    Core::ElapsedTimer timer;
+    size_t messages_sent = 0;
+    size_t messages_received = 0;
+
+    auto send_next = [&]() -> bool {
+        auto message = ByteBuffer::copy(payload);
+        if (message.is_error()) {
+            dbgln("WebSocket echo benchmark: {}", message.error());
+            return false;
+        }
+        socket->send(message.release_value(), false);
+        ++messages_sent;
+        return true;
+    };
+
+    socket->on_open = [&] {
+        timer.start();
+        while (messages_sent < min(message_count, max_messages_in_flight)) {
+            if (!send_next()) {
+                event_loop.quit(1);
+                return;
+            }
+        }
+    };
+    socket->on_message = [&](auto message) {
+        if (message.data.size() != message_size) {
+            dbgln("WebSocket echo benchmark: Expected an echo of {} bytes, got {}", message_size, message.data.size());
+            event_loop.quit(1);
+            return;
+        }
+        if (++messages_received == message_count) {
+            auto seconds = max(timer.elapsed(), 1) / 1000.0;
+            auto bytes = message_count * message_size;
+            outln("{} messages of {} bytes echoed in {:.3}s: {:.0} messages/s, {:.2} MiB/s each way",
+                message_count, message_size, seconds, message_count / seconds, bytes / seconds / MiB);
+            socket->close(1000, {});
+            return;
+        }
+        if (messages_sent < message_count && !send_next())
+            event_loop.quit(1);
+    };
+    socket->on_error = [&](auto) {
+        dbgln("WebSocket echo benchmark: Connection to {} failed", url);
+        event_loop.quit(1);
+    };
+    socket->on_close = [&](auto, auto, auto) {
+        event_loop.quit(messages_received == message_count ? 0 : 1);
+    };
+
+    return event_loop.exec();
+}
@@ -0,0 +1,15 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#define AK_DONT_REPLACE_STD
+
+#include <AK/Error.h>
+#include <AK/URL.h>
+
+// Measures WebSocket throughput through the same client sockets pages use. Sends message_count binary messages of
+// message_size bytes to an echo server, keeping a few of them in flight, and logs the round trip rate once every
+// echo has come back. Returns the process exit code.
+ErrorOr<int> run_websocket_echo_benchmark(AK::URL const& url, size_t message_count, size_t message_size);
@@ -8,6 +8,11 @@
 #define AK_DONT_REPLACE_STD
 
 #include "WebView.h"
+#include "ConnectionPool.h"
+#include "Http2Connection.h"
+#include "PreloadScanner.h"
+#include "ResponseBufferPool.h"
+#include "WebContentClient.h"
 #include <AK/Assertions.h>
 #include <AK/ByteBuffer.h>
 #include <AK/Format.h>
@@ -15,7 +20,9 @@
 #include <AK/NonnullOwnPtr.h>
 #include <AK/StringBuilder.h>
 #include <AK/Types.h>
+#include <LibCore/AnonymousBuffer.h>
 #include <LibCore/ArgsParser.h>
+#include <LibCore/ElapsedTimer.h>
 #include <LibCore/EventLoop.h>
 #include <LibCore/File.h>
 #include <LibCore/IODevice.h>
@@ -48,11 +55,18 @@
 #include <LibWebSocket/ConnectionInfo.h>
 #include <LibWebSocket/Message.h>
 #include <LibWebSocket/WebSocket.h>
+#include <QGuiApplication>
 #include <QMouseEvent>
 #include <QPaintEvent>
 #include <QPainter>
+#include <QScreen>
 #include <QScrollBar>
+#include <QTimer>
+#include <fcntl.h>
 #include <stdlib.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
 
 String s_serenity_resource_root = [] {
     auto const* source_dir = getenv("SERENITY_SOURCE_DIR");
@@ -64,237 +78,360 @@ String s_serenity_resource_root = [] {
     return String::formatted("{}/.lagom", home);
 }();
 
-class HeadlessBrowserPageClient final : public Web::PageClient {
-public:
-    static NonnullOwnPtr<HeadlessBrowserPageClient> create(WebView& view)
-    {
-        return adopt_own(*new HeadlessBrowserPageClient(view));
-    }
-
-    Web::Page& page() { return *m_page; }
-    Web::Page const& page() const { return *m_page; }
-
-    Web::Layout::InitialContainingBlock* layout_root()
-    {
-        auto* document = page().top_level_browsing_context().active_document();
-        if (!document)
-            return nullptr;
-        return document->layout_node();
-    }
-
-    void load(AK::URL const& url)
-    {
-        page().load(url);
-    }
+// Only used where the process start time can't be read. Started by initialize_web_engine(),
+// which is the first thing serenity_main() does.
+static Core::ElapsedTimer s_launch_timer;
+static bool s_has_reported_first_paint { false };
 
-    void paint(Gfx::IntRect const& content_rect, Gfx::Bitmap& target)
-    {
-        Gfx::Painter painter(target);
-
-        if (auto* document = page().top_level_browsing_context().active_document())
-            document->update_layout();
-
-        painter.fill_rect({ {}, content_rect.size() }, palette().base());
-
-        auto* layout_root = this->layout_root();
-        if (!layout_root) {
-            return;
-        }
-
-        Web::PaintContext context(painter, palette(), content_rect.top_left());
-        context.set_should_show_line_box_borders(false);
-        context.set_viewport_rect(content_rect);
-        context.set_has_focus(true);
-        layout_root->paint_all_phases(context);
-    }
-
-    void setup_palette(Core::AnonymousBuffer theme_buffer)
-    {
-        m_palette_impl = Gfx::PaletteImpl::create_with_anonymous_buffer(theme_buffer);
-    }
+// How long ago the kernel started this process, including dynamic linking and static initialization.
+// For a browser forked by the fork server, that's when it was forked.
+static Optional<i64> milliseconds_since_process_start()
+{
+    auto fd_or_error = Core::System::open("/proc/self/stat", O_RDONLY | O_CLOEXEC);
+    if (fd_or_error.is_error())
+        return {};
+    char buffer[1024];
+    auto nread_or_error = Core::System::read(fd_or_error.value(), { buffer, sizeof(buffer) });
+    (void)Core::System::close(fd_or_error.value());
+    if (nread_or_error.is_error())
+        return {};
+
+    // The command name is in parentheses and may contain spaces, so count fields from the closing one.
+    // The start time is field 22, in clock ticks since boot. Field 3 is the first one after the name.
+    StringView stat { buffer, nread_or_error.value() };
+    auto name_end = stat.find_last(')');
+    if (!name_end.has_value())
+        return {};
+    auto fields = stat.substring_view(*name_end + 1).split_view(' ');
+    if (fields.size() < 20)
+        return {};
+    auto start_time_in_ticks = fields[19].to_uint<u64>();
+    if (!start_time_in_ticks.has_value())
+        return {};
+
+    timespec now;
+    if (clock_gettime(CLOCK_BOOTTIME, &now) < 0)
+        return {};
+    auto now_ms = static_cast<i64>(now.tv_sec) * 1000 + now.tv_nsec / 1'000'000;
+    return now_ms - static_cast<i64>(*start_time_in_ticks * 1000 / sysconf(_SC_CLK_TCK));
+}
 
-    void set_viewport_rect(Gfx::IntRect rect)
-    {
-        m_viewport_rect = rect;
-        page().top_level_browsing_context().set_viewport_rect(rect);
-    }
+static i64 milliseconds_since_launch()
+{
+    return milliseconds_since_process_start().value_or(s_launch_timer.elapsed());
+}
 
-    // ^Web::PageClient
-    virtual Gfx::Palette palette() const override
-    {
-        return Gfx::Palette(*m_palette_impl);
-    }
+Core::AnonymousBuffer s_theme_buffer;
+
+static HashTable<WebView*> s_views_with_scheduled_frame;
+
+// How much nicer than us the WebContent processes of hidden tabs run.
+static constexpr int hidden_web_content_nice_increment = 10;
+
+// Every process may lower its children's priority, but raising it back to our own needs CAP_SYS_NICE or a RLIMIT_NICE
+// that allows it. Without either, a tab would stay slow for good once it has been hidden, so it isn't deprioritized.
+static Optional<int> s_web_content_nice = []() -> Optional<int> {
+    errno = 0;
+    auto nice = getpriority(PRIO_PROCESS, 0);
+    if (errno != 0)
+        return {};
+    if (geteuid() == 0)
+        return nice;
+#ifdef RLIMIT_NICE
+    rlimit limit {};
+    if (getrlimit(RLIMIT_NICE, &limit) == 0 && (limit.rlim_cur == RLIM_INFINITY || static_cast<rlim_t>(20 - nice) <= limit.rlim_cur))
+        return nice;
+#endif
+    dbgln("WebView: Not deprioritizing hidden tabs, as their priority couldn't be restored (see RLIMIT_NICE)");
+    return {};
+}();
 
-    virtual Gfx::IntRect screen_rect() const override
-    {
-        // FIXME: Return the actual screen rect.
-        return m_viewport_rect;
-    }
+WebView::WebView()
+{
+    setMouseTracking(true);
 
-    Gfx::IntRect viewport_rect() const
-    {
-        return m_viewport_rect;
-    }
+    // FIXME: Allow passing these values as arguments
+    m_viewport_rect = { 0, 0, 800, 600 };
 
-    virtual Web::CSS::PreferredColorScheme preferred_color_scheme() const override
-    {
-        return m_preferred_color_scheme;
-    }
+    m_resize_settle_timer = Core::Timer::create_single_shot(resize_settle_delay_ms, [this] {
+        did_finish_resizing();
+    });
 
-    virtual void page_did_change_title(String const& title) override
-    {
-        emit m_view.title_changed(title.characters());
-    }
+    spawn_web_content_process();
+}
 
-    virtual void page_did_set_document_in_top_level_browsing_context(Web::DOM::Document*) override
-    {
-    }
+WebView::~WebView()
+{
+    s_views_with_scheduled_frame.remove(this);
+}
 
-    virtual void page_did_start_loading(AK::URL const& url) override
-    {
-        emit m_view.loadStarted(url.to_string().characters());
+void WebView::spawn_web_content_process()
+{
+    auto client_or_error = WebContentClient::spawn();
+    if (client_or_error.is_error()) {
+        warnln("Failed to spawn WebContent process: {}", client_or_error.error());
+        return;
     }
+    m_client = client_or_error.release_value();
 
-    virtual void page_did_finish_loading(AK::URL const&) override
-    {
-    }
+    m_client->on_did_paint = [this](i32 backing_store_id, Gfx::IntRect const& content_rect, u32 paint_time_ms) {
+        did_paint(backing_store_id, content_rect, paint_time_ms);
+    };
+    m_client->on_did_invalidate = [this](Gfx::IntRect const&) {
+        did_invalidate();
+    };
+    m_client->on_did_layout = [this](Gfx::IntSize const& content_size) {
+        verticalScrollBar()->setMaximum(content_size.height() - m_viewport_rect.height());
+        horizontalScrollBar()->setMaximum(content_size.width() - m_viewport_rect.width());
+    };
+    m_client->on_title_change = [this](String const& title) {
+        emit title_changed(title.characters());
+    };
+    m_client->on_load_start = [this](String const& url) {
+        emit loadStarted(url.characters());
+    };
+    m_client->on_link_hover = [this](String const& url) {
+        emit linkHovered(url.characters());
+    };
+    m_client->on_link_unhover = [this] {
+        emit linkUnhovered();
+    };
+    m_client->on_history_state_change = [this](bool can_go_back, bool can_go_forward) {
+        emit history_state_changed(can_go_back, can_go_forward);
+    };
+    m_client->on_crash = [this] {
+        // We're being called from inside the client's message handling, so don't destroy it right away.
+        QTimer::singleShot(0, this, [this] { did_crash(); });
+    };
 
-    virtual void page_did_change_selection() override
-    {
+    m_client->async_set_viewport_rect(m_viewport_rect);
+    if (!m_active) {
+        m_client->async_set_visible(false);
+        update_web_content_priority();
     }
+}
 
-    virtual void page_did_request_cursor_change(Gfx::StandardCursor) override
-    {
-    }
+void WebView::did_crash()
+{
+    m_client = nullptr;
+    m_front_backing_store = {};
+    m_back_backing_store = {};
+    m_has_paint_in_flight = false;
+    m_needs_repaint = true;
+    viewport()->update();
+}
 
-    virtual void page_did_request_context_menu(Gfx::IntPoint const&) override
-    {
-    }
+void WebView::load(String const& url)
+{
+    if (!m_client)
+        spawn_web_content_process();
+    if (!m_client)
+        return;
+    m_client->async_load_url(AK::URL(url));
+}
 
-    virtual void page_did_request_link_context_menu(Gfx::IntPoint const&, AK::URL const&, String const&, unsigned) override
-    {
-    }
+void WebView::go_back()
+{
+    if (m_client)
+        m_client->async_go_back();
+}
 
-    virtual void page_did_request_image_context_menu(Gfx::IntPoint const&, AK::URL const&, String const&, unsigned, Gfx::Bitmap const*) override
-    {
-    }
+void WebView::go_forward()
+{
+    if (m_client)
+        m_client->async_go_forward();
+}
 
-    virtual void page_did_click_link(AK::URL const&, String const&, unsigned) override
-    {
+void WebView::set_active(bool active)
+{
+    if (m_active == active)
+        return;
+    m_active = active;
+    if (m_client) {
+        m_client->async_set_visible(m_active);
+        update_web_content_priority();
     }
-
-    virtual void page_did_middle_click_link(AK::URL const&, String const&, unsigned) override
-    {
+    if (m_active) {
+        if (!m_front_backing_store.bitmap)
+            m_needs_repaint = true;
+        send_paint_request_if_needed();
+        viewport()->update();
     }
+}
 
-    virtual void page_did_enter_tooltip_area(Gfx::IntPoint const&, String const&) override
-    {
-    }
+void WebView::update_web_content_priority()
+{
+    if (!s_web_content_nice.has_value())
+        return;
+    auto nice = m_active ? *s_web_content_nice : min(*s_web_content_nice + hidden_web_content_nice_increment, 19);
+    if (setpriority(PRIO_PROCESS, m_client->pid(), nice) < 0)
+        dbgln("WebView: Failed to set the priority of WebContent process {}: {}", m_client->pid(), Error::from_errno(errno));
+}
 
-    virtual void page_did_leave_tooltip_area() override
-    {
-    }
+void WebView::did_invalidate()
+{
+    ++m_event_counters.invalidations_received;
+    request_repaint();
+}
 
-    virtual void page_did_hover_link(AK::URL const& url) override
-    {
-        emit m_view.linkHovered(url.to_string().characters());
+size_t WebView::discard_backing_store()
+{
+    size_t freed_bytes = 0;
+    if (m_front_backing_store.bitmap)
+        freed_bytes += m_front_backing_store.bitmap->size_in_bytes();
+    if (m_back_backing_store.bitmap)
+        freed_bytes += m_back_backing_store.bitmap->size_in_bytes();
+
+    if (m_client) {
+        if (m_front_backing_store.bitmap)
+            m_client->async_remove_backing_store(m_front_backing_store.id);
+        if (m_back_backing_store.bitmap)
+            m_client->async_remove_backing_store(m_back_backing_store.id);
     }
+    m_front_backing_store = {};
+    m_back_backing_store = {};
+    m_needs_repaint = true;
+    return freed_bytes;
+}
 
-    virtual void page_did_unhover_link() override
-    {
-        emit m_view.linkUnhovered();
-    }
+void WebView::request_repaint()
+{
+    m_needs_repaint = true;
+    schedule_frame();
+}
 
-    virtual void page_did_invalidate(Gfx::IntRect const&) override
-    {
-        m_view.viewport()->update();
-    }
+int WebView::frame_interval_ms()
+{
+    auto* screen = QGuiApplication::primaryScreen();
+    auto refresh_rate = screen ? screen->refreshRate() : 60.0;
+    if (refresh_rate <= 0)
+        refresh_rate = 60.0;
+    return max(1, static_cast<int>(1000.0 / refresh_rate));
+}
 
-    virtual void page_did_change_favicon(Gfx::Bitmap const&) override
-    {
-    }
+void WebView::schedule_frame()
+{
+    s_views_with_scheduled_frame.set(this);
+}
 
-    virtual void page_did_layout() override
-    {
-        auto* layout_root = this->layout_root();
-        VERIFY(layout_root);
-        Gfx::IntSize content_size;
-        if (layout_root->paint_box()->has_overflow())
-            content_size = enclosing_int_rect(layout_root->paint_box()->scrollable_overflow_rect().value()).size();
-        else
-            content_size = enclosing_int_rect(layout_root->paint_box()->absolute_rect()).size();
+void WebView::dispatch_scheduled_frames()
+{
+    if (s_views_with_scheduled_frame.is_empty())
+        return;
+    // Dispatching may schedule another frame, which then waits for the next tick.
+    auto views = move(s_views_with_scheduled_frame);
+    for (auto* view : views)
+        view->dispatch_frame();
+}
 
-        m_view.verticalScrollBar()->setMaximum(content_size.height() - m_viewport_rect.height());
-        m_view.horizontalScrollBar()->setMaximum(content_size.width() - m_viewport_rect.width());
-    }
+void WebView::dispatch_frame()
+{
+    dispatch_pending_mouse_move();
+    send_paint_request_if_needed();
+}
 
-    virtual void page_did_request_scroll_into_view(Gfx::IntRect const&) override
-    {
-    }
+void WebView::dispatch_pending_mouse_move()
+{
+    if (!m_pending_mouse_move.has_value())
+        return;
+    auto mouse_move = m_pending_mouse_move.release_value();
+    if (!m_client)
+        return;
+    ++m_event_counters.mouse_moves_dispatched;
+    m_client->async_mouse_move(mouse_move.position, mouse_move.buttons, mouse_move.modifiers);
+}
 
-    virtual void page_did_request_alert(String const&) override
-    {
-    }
+Gfx::IntRect WebView::content_rect() const
+{
+    return { horizontalScrollBar()->value(), verticalScrollBar()->value(), m_viewport_rect.width(), m_viewport_rect.height() };
+}
 
-    virtual bool page_did_request_confirm(String const&) override
-    {
+bool WebView::ensure_back_backing_store()
+{
+    auto size = m_viewport_rect.size();
+    if (size.is_empty())
         return false;
-    }
-
-    virtual String page_did_request_prompt(String const&, String const&) override
-    {
-        return String::empty();
-    }
-
-    virtual String page_did_request_cookie(AK::URL const&, Web::Cookie::Source) override
-    {
-        return String::empty();
-    }
-
-    virtual void page_did_set_cookie(AK::URL const&, Web::Cookie::ParsedCookie const&, Web::Cookie::Source) override
-    {
-    }
-
-    void request_file(NonnullRefPtr<Web::FileRequest>& request) override
-    {
-        auto const file = Core::System::open(request->path(), O_RDONLY);
-        request->on_file_request_finish(file);
-    }
+    if (m_back_backing_store.bitmap && m_back_backing_store.bitmap->size() == size)
+        return true;
 
-private:
-    HeadlessBrowserPageClient(WebView& view)
-        : m_view(view)
-        , m_page(make<Web::Page>(*this))
-    {
+    auto bitmap_or_error = Gfx::Bitmap::try_create_shareable(Gfx::BitmapFormat::BGRx8888, size);
+    if (bitmap_or_error.is_error()) {
+        dbgln("Failed to allocate {} backing store: {}", size, bitmap_or_error.error());
+        return false;
     }
 
-    WebView& m_view;
-    NonnullOwnPtr<Web::Page> m_page;
-
-    RefPtr<Gfx::PaletteImpl> m_palette_impl;
-    Gfx::IntRect m_viewport_rect { 0, 0, 800, 600 };
-    Web::CSS::PreferredColorScheme m_preferred_color_scheme { Web::CSS::PreferredColorScheme::Auto };
-};
+    if (m_back_backing_store.bitmap)
+        m_client->async_remove_backing_store(m_back_backing_store.id);
+    m_back_backing_store = { m_next_backing_store_id++, bitmap_or_error.release_value() };
+    m_client->add_backing_store(m_back_backing_store.id, *m_back_backing_store.bitmap);
+    return true;
+}
 
-WebView::WebView()
+void WebView::send_paint_request_if_needed()
 {
-    setMouseTracking(true);
-
-    m_page_client = HeadlessBrowserPageClient::create(*this);
-
-    m_page_client->setup_palette(Gfx::load_system_theme(String::formatted("{}/res/themes/Default.ini", s_serenity_resource_root)));
-
-    // FIXME: Allow passing these values as arguments
-    m_page_client->set_viewport_rect({ 0, 0, 800, 600 });
+    // The WebContent process paints into the back backing store while we keep showing the front one.
+    // There is at most one paint in flight; anything invalidated meanwhile gets picked up once it's done.
+    if (!m_client || !m_active || !m_needs_repaint || m_has_paint_in_flight)
+        return;
+    if (!ensure_back_backing_store())
+        return;
+
+    m_needs_repaint = false;
+    m_has_paint_in_flight = true;
+    ++m_event_counters.paints_dispatched;
+    m_paint_request_timer.start();
+    m_client->async_paint(content_rect(), m_back_backing_store.id);
 }
 
-WebView::~WebView()
+void WebView::did_paint(i32 backing_store_id, Gfx::IntRect const& content_rect, u32 paint_time_ms)
 {
+    m_has_paint_in_flight = false;
+
+    // The backing store may have been discarded while the WebContent process was painting into it.
+    if (m_back_backing_store.bitmap && backing_store_id == m_back_backing_store.id) {
+        if (m_front_backing_store.bitmap && !m_front_frame_was_presented)
+            ++m_frame_statistics.frames_dropped;
+        swap(m_front_backing_store, m_back_backing_store);
+        m_front_content_rect = content_rect;
+        m_front_frame_was_presented = false;
+        update_frame_statistics(paint_time_ms);
+        viewport()->update();
+
+        if (m_is_waiting_for_settled_frame && !m_resize_settle_timer->is_active() && content_rect.size() == m_viewport_rect.size())
+            report_resize_statistics();
+    }
+
+    if (m_needs_repaint)
+        schedule_frame();
 }
 
-void WebView::load(String const& url)
+void WebView::update_frame_statistics(u32 paint_time_ms)
 {
-    m_page_client->load(AK::URL(url));
+    auto& statistics = m_frame_statistics;
+    u32 latency_ms = m_paint_request_timer.elapsed();
+
+    ++statistics.frames_produced;
+    statistics.total_paint_time_ms += paint_time_ms;
+    statistics.max_paint_time_ms = max(statistics.max_paint_time_ms, paint_time_ms);
+    statistics.total_latency_ms += latency_ms;
+    statistics.max_latency_ms = max(statistics.max_latency_ms, latency_ms);
+
+    static constexpr size_t frames_per_report = 100;
+    if (statistics.frames_produced % frames_per_report != 0)
+        return;
+
+    dbgln("WebView: {} frames produced, {} dropped. Paint time avg {}ms, max {}ms. Request to frame avg {}ms, max {}ms.",
+        statistics.frames_produced,
+        statistics.frames_dropped,
+        statistics.total_paint_time_ms / statistics.frames_produced,
+        statistics.max_paint_time_ms,
+        statistics.total_latency_ms / statistics.frames_produced,
+        statistics.max_latency_ms);
+    dbgln("WebView: {} invalidations coalesced into {} paints, {} mouse moves coalesced into {}.",
+        m_event_counters.invalidations_received,
+        m_event_counters.paints_dispatched,
+        m_event_counters.mouse_moves_received,
+        m_event_counters.mouse_moves_dispatched);
 }
 
 unsigned get_button_from_qt_event(QMouseEvent const& event)
@@ -337,7 +474,11 @@ void WebView::mouseMoveEvent(QMouseEvent* event)
     Gfx::IntPoint position(event->x(), event->y());
     auto buttons = get_buttons_from_qt_event(*event);
     auto modifiers = get_modifiers_from_qt_event(*event);
-    m_page_client->page().handle_mousemove(to_content(position), buttons, modifiers);
+
+    // Only the most recent position matters, so hold on to it until the next frame.
+    ++m_event_counters.mouse_moves_received;
+    m_pending_mouse_move = PendingMouseMove { to_content(position), buttons, modifiers };
+    schedule_frame();
 }
 
 void WebView::mousePressEvent(QMouseEvent* event)
@@ -345,7 +486,10 @@ void WebView::mousePressEvent(QMouseEvent* event)
     Gfx::IntPoint position(event->x(), event->y());
     auto button = get_button_from_qt_event(*event);
     auto modifiers = get_modifiers_from_qt_event(*event);
-    m_page_client->page().handle_mousedown(to_content(position), button, modifiers);
+    // A move that's still pending happened before this, so it goes out first.
+    dispatch_pending_mouse_move();
+    if (m_client)
+        m_client->async_mouse_down(to_content(position), button, modifiers);
 }
 
 void WebView::mouseReleaseEvent(QMouseEvent* event)
@@ -353,7 +497,9 @@ void WebView::mouseReleaseEvent(QMouseEvent* event)
     Gfx::IntPoint position(event->x(), event->y());
     auto button = get_button_from_qt_event(*event);
     auto modifiers = get_modifiers_from_qt_event(*event);
-    m_page_client->page().handle_mouseup(to_content(position), button, modifiers);
+    dispatch_pending_mouse_move();
+    if (m_client)
+        m_client->async_mouse_up(to_content(position), button, modifiers);
 }
 
 Gfx::IntPoint WebView::to_content(Gfx::IntPoint viewport_position) const
@@ -363,24 +509,88 @@ Gfx::IntPoint WebView::to_content(Gfx::IntPoint viewport_position) const
 
 void WebView::paintEvent(QPaintEvent* event)
 {
+    if (!m_active)
+        return;
+
     QPainter painter(viewport());
     painter.setClipRect(event->rect());
 
-    auto output_rect = m_page_client->viewport_rect();
-    output_rect.set_x(horizontalScrollBar()->value());
-    output_rect.set_y(verticalScrollBar()->value());
-    auto output_bitmap = MUST(Gfx::Bitmap::try_create(Gfx::BitmapFormat::BGRx8888, output_rect.size()));
+    auto* bitmap = m_front_backing_store.bitmap.ptr();
+    if (!bitmap) {
+        painter.fillRect(event->rect(), palette().base());
+        return;
+    }
 
-    m_page_client->paint(output_rect, output_bitmap);
+    // If we've scrolled or resized since this frame was painted, show it where it belongs until the next one arrives.
+    // Whatever it doesn't cover gets the base color.
+    auto offset = m_front_content_rect.location() - content_rect().location();
+    if (!offset.is_null() || bitmap->width() < viewport()->width() || bitmap->height() < viewport()->height())
+        painter.fillRect(event->rect(), palette().base());
 
-    QImage q_image(output_bitmap->scanline_u8(0), output_bitmap->width(), output_bitmap->height(), QImage::Format_RGB32);
-    painter.drawImage(QPoint(0, 0), q_image);
+    QImage q_image(bitmap->scanline_u8(0), bitmap->width(), bitmap->height(), QImage::Format_RGB32);
+    painter.drawImage(QPoint(offset.x(), offset.y()), q_image);
+    m_front_frame_was_presented = true;
+
+    if (!s_has_reported_first_paint) {
+        s_has_reported_first_paint = true;
+        dbgln("Launch to first paint: {}ms", milliseconds_since_launch());
+    }
 }
 
 void WebView::resizeEvent(QResizeEvent* event)
 {
-    Gfx::IntRect rect(horizontalScrollBar()->value(), verticalScrollBar()->value(), event->size().width(), event->size().height());
-    m_page_client->set_viewport_rect(rect);
+    // While the user is dragging the window edge, we keep showing the last frame clipped to the new size
+    // and only relayout at a bounded rate. Once resizing settles, we do one final layout at the exact size.
+    m_pending_viewport_size = { event->size().width(), event->size().height() };
+    ++m_resize_statistics.resize_events;
+
+    if (!m_last_resize_relayout_timer.is_valid() || m_last_resize_relayout_timer.elapsed() >= resize_relayout_interval_ms)
+        apply_pending_viewport_size();
+
+    m_resize_settle_timer->restart();
+}
+
+bool WebView::apply_pending_viewport_size()
+{
+    if (m_viewport_rect.size() == m_pending_viewport_size)
+        return false;
+
+    m_last_resize_relayout_timer.start();
+    ++m_resize_statistics.relayouts;
+
+    m_viewport_rect = { horizontalScrollBar()->value(), verticalScrollBar()->value(), m_pending_viewport_size.width(), m_pending_viewport_size.height() };
+    if (m_client)
+        m_client->async_set_viewport_rect(m_viewport_rect);
+    request_repaint();
+    return true;
+}
+
+void WebView::did_finish_resizing()
+{
+    m_settled_frame_timer.start();
+
+    // The throttled relayouts may already have covered the final size, in which case its frame may be on screen already.
+    if (!apply_pending_viewport_size() && m_front_content_rect.size() == m_viewport_rect.size()) {
+        report_resize_statistics();
+        return;
+    }
+    m_is_waiting_for_settled_frame = true;
+}
+
+void WebView::report_resize_statistics()
+{
+    dbgln("WebView: Resize took {} resize events and {} relayouts, final frame {}ms after settling",
+        m_resize_statistics.resize_events,
+        m_resize_statistics.relayouts,
+        m_settled_frame_timer.elapsed());
+    m_resize_statistics = {};
+    m_is_waiting_for_settled_frame = false;
+}
+
+void WebView::scrollContentsBy(int, int)
+{
+    viewport()->update();
+    request_repaint();
 }
 
 class HeadlessImageDecoderClient : public Web::ImageDecoding::Decoder {
@@ -428,35 +638,42 @@ static HashTable<RefPtr<Web::ResourceLoaderConnectorRequest>> s_all_requests;
 
 class HeadlessRequestServer : public Web::ResourceLoaderConnector {
 public:
-    class HTTPHeadlessRequest
+    // The part shared by all protocols: runs a job on an already connected socket, collects the response
+    // into a pooled buffer and hands it to the ResourceLoader once it's complete.
+    // With a connection pool origin, the socket is given back to the ConnectionPool afterwards if the server kept it open.
+    // A server may close an idle connection just as we reuse it, before its FIN has reached us. So if a request on a
+    // reused connection fails before any of the response arrives, it's sent once more on a fresh connection, as long as
+    // it's safe to repeat.
+    // Over HTTP/2, the request is a stream on the origin's shared connection instead, and there's no job or socket of
+    // its own. A stream the server refused is always sent once more, since the server never processed it.
+    class BufferedHeadlessRequest
         : public Web::ResourceLoaderConnectorRequest
-        , public Weakable<HTTPHeadlessRequest> {
+        , public Weakable<BufferedHeadlessRequest> {
     public:
-        static ErrorOr<NonnullRefPtr<HTTPHeadlessRequest>> create(String const& method, AK::URL const& url, HashMap<String, String> const& request_headers, ReadonlyBytes request_body, Core::ProxyData const&)
+        using JobFactory = Function<NonnullRefPtr<Core::NetworkJob>(Core::Stream::Stream& output_stream)>;
+        using Connector = Function<ErrorOr<NonnullOwnPtr<Core::Stream::BufferedSocketBase>>()>;
+        using Http2Connector = Function<ErrorOr<NonnullRefPtr<Http2Connection>>()>;
+
+        // Without a connector to open a fresh connection, a failed request is never retried.
+        static ErrorOr<NonnullRefPtr<BufferedHeadlessRequest>> create(NonnullOwnPtr<Core::Stream::BufferedSocketBase> socket, bool socket_was_reused, String connection_pool_origin, Connector connect_fresh, JobFactory create_job)
         {
-            auto stream_backing_buffer = TRY(ByteBuffer::create_uninitialized(1 * MiB));
-            auto underlying_socket = TRY(Core::Stream::TCPSocket::connect(url.host(), url.port().value_or(80)));
-            TRY(underlying_socket->set_blocking(false));
-            auto socket = TRY(Core::Stream::BufferedSocket<Core::Stream::TCPSocket>::create(move(underlying_socket)));
-
-            HTTP::HttpRequest request;
-            if (method.equals_ignoring_case("head"sv))
-                request.set_method(HTTP::HttpRequest::HEAD);
-            else if (method.equals_ignoring_case("get"sv))
-                request.set_method(HTTP::HttpRequest::GET);
-            else if (method.equals_ignoring_case("post"sv))
-                request.set_method(HTTP::HttpRequest::POST);
-            else
-                request.set_method(HTTP::HttpRequest::Invalid);
-            request.set_url(move(url));
-            request.set_headers(request_headers);
-            request.set_body(TRY(ByteBuffer::copy(request_body)));
-
-            return adopt_ref(*new HTTPHeadlessRequest(move(request), move(socket), move(stream_backing_buffer)));
-        }
-
-        virtual ~HTTPHeadlessRequest() override
+            auto output_stream = TRY(PooledResponseStream::create());
+            return adopt_ref(*new BufferedHeadlessRequest(move(socket), socket_was_reused, move(connection_pool_origin), move(output_stream), move(connect_fresh), move(create_job)));
+        }
+
+        static ErrorOr<NonnullRefPtr<BufferedHeadlessRequest>> create_http2(HTTP::HttpRequest request, Http2Connector connect)
+        {
+            auto output_stream = TRY(PooledResponseStream::create());
+            auto buffered_request = adopt_ref(*new BufferedHeadlessRequest(move(request), move(output_stream), move(connect)));
+            TRY(buffered_request->start_http2_stream());
+            return buffered_request;
+        }
+
+        virtual ~BufferedHeadlessRequest() override
         {
+            // Nobody wants the response anymore, so the server may as well stop sending it.
+            if (m_http2_connection)
+                m_http2_connection->cancel_stream(m_http2_stream_token);
         }
 
         virtual void set_should_buffer_all_input(bool) override
@@ -472,186 +689,349 @@ public:
         {
         }
 
-    private:
-        HTTPHeadlessRequest(HTTP::HttpRequest&& request, NonnullOwnPtr<Core::Stream::BufferedSocketBase> socket, ByteBuffer&& stream_backing_buffer)
-            : m_stream_backing_buffer(move(stream_backing_buffer))
-            , m_output_stream(Core::Stream::MemoryStream::construct(m_stream_backing_buffer.bytes()).release_value_but_fixme_should_propagate_errors())
-            , m_socket(move(socket))
-            , m_job(HTTP::Job::construct(move(request), *m_output_stream))
+        // Scans the response for subresources while it arrives, if it turns out to be HTML.
+        void enable_preload_scanning(AK::URL const& document_url, Function<void(Vector<AK::URL>)> on_preload_urls)
         {
-            m_job->on_headers_received = [weak_this = make_weak_ptr()](auto& response_headers, auto response_code) mutable {
-                if (auto strong_this = weak_this.strong_ref()) {
-                    strong_this->m_response_code = response_code;
-                    for (auto& header : response_headers) {
-                        strong_this->m_response_headers.set(header.key, header.value);
-                    }
-                }
-            };
-            m_job->on_finish = [weak_this = make_weak_ptr()](bool success) mutable {
-                Core::deferred_invoke([weak_this, success]() mutable {
-                    if (auto strong_this = weak_this.strong_ref()) {
-                        ReadonlyBytes response_bytes { strong_this->m_output_stream->bytes().data(), strong_this->m_output_stream->offset() };
-                        auto response_buffer = ByteBuffer::copy(response_bytes).release_value_but_fixme_should_propagate_errors();
-                        strong_this->on_buffered_request_finish(success, strong_this->m_output_stream->offset(), strong_this->m_response_headers, strong_this->m_response_code, response_buffer);
-                    } });
-            };
-            m_job->start(*m_socket);
+            m_preload_scanner = make<PreloadScanner>(document_url);
+            m_on_preload_urls = move(on_preload_urls);
         }
 
-        Optional<u32> m_response_code;
-        ByteBuffer m_stream_backing_buffer;
-        NonnullOwnPtr<Core::Stream::MemoryStream> m_output_stream;
-        NonnullOwnPtr<Core::Stream::BufferedSocketBase> m_socket;
-        NonnullRefPtr<HTTP::Job> m_job;
-        HashMap<String, String, CaseInsensitiveStringTraits> m_response_headers;
-    };
+        bool has_failed() const { return m_has_finished && !m_success; }
+        bool has_finished() const { return m_has_finished; }
+        Core::ElapsedTimer const& started_timer() const { return m_started_timer; }
+        Core::ElapsedTimer const& finished_timer() const { return m_finished_timer; }
+        size_t buffered_size() const { return m_output_stream->size(); }
 
-    class HTTPSHeadlessRequest
-        : public Web::ResourceLoaderConnectorRequest
-        , public Weakable<HTTPSHeadlessRequest> {
-    public:
-        static ErrorOr<NonnullRefPtr<HTTPSHeadlessRequest>> create(String const& method, AK::URL const& url, HashMap<String, String> const& request_headers, ReadonlyBytes request_body, Core::ProxyData const&)
+        // Stops a request that's still in flight, without ever finishing it. The connection isn't reused.
+        void cancel()
         {
-            auto stream_backing_buffer = TRY(ByteBuffer::create_uninitialized(1 * MiB));
-            auto underlying_socket = TRY(TLS::TLSv12::connect(url.host(), url.port().value_or(443)));
-            TRY(underlying_socket->set_blocking(false));
-            auto socket = TRY(Core::Stream::BufferedSocket<TLS::TLSv12>::create(move(underlying_socket)));
-
-            HTTP::HttpRequest request;
-            if (method.equals_ignoring_case("head"sv))
-                request.set_method(HTTP::HttpRequest::HEAD);
-            else if (method.equals_ignoring_case("get"sv))
-                request.set_method(HTTP::HttpRequest::GET);
-            else if (method.equals_ignoring_case("post"sv))
-                request.set_method(HTTP::HttpRequest::POST);
-            else
-                request.set_method(HTTP::HttpRequest::Invalid);
-            request.set_url(move(url));
-            request.set_headers(request_headers);
-            request.set_body(TRY(ByteBuffer::copy(request_body)));
-
-            return adopt_ref(*new HTTPSHeadlessRequest(move(request), move(socket), move(stream_backing_buffer)));
-        }
-
-        virtual ~HTTPSHeadlessRequest() override
+            if (m_has_finished)
+                return;
+            if (m_job) {
+                m_job->on_headers_received = nullptr;
+                m_job->on_progress = nullptr;
+                m_job->on_finish = nullptr;
+                m_job->cancel();
+                m_job = nullptr;
+            }
+            m_socket = nullptr;
+            if (m_http2_connection) {
+                m_http2_connection->cancel_stream(m_http2_stream_token);
+                m_http2_connection = nullptr;
+            }
+        }
+
+        // Called once the ResourceLoader takes over a speculative request. If the response is already complete,
+        // it's delivered as soon as the ResourceLoader has set up its callback.
+        void did_claim()
         {
+            if (!m_has_finished)
+                return;
+            Core::deferred_invoke([strong_this = NonnullRefPtr(*this)] {
+                if (strong_this->on_buffered_request_finish)
+                    strong_this->deliver_response();
+            });
         }
 
-        virtual void set_should_buffer_all_input(bool) override
+    private:
+        BufferedHeadlessRequest(NonnullOwnPtr<Core::Stream::BufferedSocketBase> socket, bool socket_was_reused, String connection_pool_origin, NonnullOwnPtr<PooledResponseStream> output_stream, Connector connect_fresh, JobFactory create_job)
+            : m_output_stream(move(output_stream))
+            , m_socket(move(socket))
+            , m_socket_was_reused(socket_was_reused)
+            , m_connection_pool_origin(move(connection_pool_origin))
+            , m_connect_fresh(move(connect_fresh))
+            , m_create_job(move(create_job))
+            , m_job(m_create_job(*m_output_stream))
+            , m_started_timer(Core::ElapsedTimer::start_new())
         {
+            start_job();
         }
 
-        virtual bool stop() override
+        BufferedHeadlessRequest(HTTP::HttpRequest request, NonnullOwnPtr<PooledResponseStream> output_stream, Http2Connector connect)
+            : m_output_stream(move(output_stream))
+            , m_http2_request(move(request))
+            , m_http2_connect(move(connect))
+            , m_started_timer(Core::ElapsedTimer::start_new())
         {
-            return false;
         }
 
-        virtual void stream_into(Core::Stream::Stream&) override
+        void did_receive_headers(HashMap<String, String, CaseInsensitiveStringTraits> const& response_headers, Optional<u32> response_code)
         {
+            m_response_code = response_code;
+            for (auto& header : response_headers)
+                m_response_headers.set(header.key, header.value);
+            auto content_type = m_response_headers.get("Content-Type");
+            if (!content_type.has_value() || !content_type->starts_with("text/html"sv, CaseSensitivity::CaseInsensitive))
+                m_preload_scanner = nullptr;
         }
 
-    private:
-        HTTPSHeadlessRequest(HTTP::HttpRequest&& request, NonnullOwnPtr<Core::Stream::BufferedSocketBase> socket, ByteBuffer&& stream_backing_buffer)
-            : m_stream_backing_buffer(move(stream_backing_buffer))
-            , m_output_stream(Core::Stream::MemoryStream::construct(m_stream_backing_buffer.bytes()).release_value_but_fixme_should_propagate_errors())
-            , m_socket(move(socket))
-            , m_job(HTTP::HttpsJob::construct(move(request), *m_output_stream))
+        void did_receive_data()
+        {
+            if (!m_preload_scanner)
+                return;
+            auto urls = m_preload_scanner->scan(m_output_stream->bytes());
+            if (!urls.is_empty())
+                m_on_preload_urls(move(urls));
+        }
+
+        void start_job()
         {
             m_job->on_headers_received = [weak_this = make_weak_ptr()](auto& response_headers, auto response_code) mutable {
-                if (auto strong_this = weak_this.strong_ref()) {
-                    strong_this->m_response_code = response_code;
-                    for (auto& header : response_headers) {
-                        strong_this->m_response_headers.set(header.key, header.value);
-                    }
-                }
+                if (auto strong_this = weak_this.strong_ref())
+                    strong_this->did_receive_headers(response_headers, response_code);
+            };
+            m_job->on_progress = [weak_this = make_weak_ptr()](auto, auto) mutable {
+                if (auto strong_this = weak_this.strong_ref())
+                    strong_this->did_receive_data();
             };
             m_job->on_finish = [weak_this = make_weak_ptr()](bool success) mutable {
                 Core::deferred_invoke([weak_this, success]() mutable {
-                    if (auto strong_this = weak_this.strong_ref()) {
-                        ReadonlyBytes response_bytes { strong_this->m_output_stream->bytes().data(), strong_this->m_output_stream->offset() };
-                        auto response_buffer = ByteBuffer::copy(response_bytes).release_value_but_fixme_should_propagate_errors();
-                        strong_this->on_buffered_request_finish(success, strong_this->m_output_stream->offset(), strong_this->m_response_headers, strong_this->m_response_code, response_buffer);
-                    } });
+                    if (auto strong_this = weak_this.strong_ref())
+                        strong_this->did_finish(success);
+                });
             };
             m_job->start(*m_socket);
         }
 
-        Optional<u32> m_response_code;
-        ByteBuffer m_stream_backing_buffer;
-        NonnullOwnPtr<Core::Stream::MemoryStream> m_output_stream;
-        NonnullOwnPtr<Core::Stream::BufferedSocketBase> m_socket;
-        NonnullRefPtr<HTTP::HttpsJob> m_job;
-        HashMap<String, String, CaseInsensitiveStringTraits> m_response_headers;
-    };
-
-    class GeminiHeadlessRequest
-        : public Web::ResourceLoaderConnectorRequest
-        , public Weakable<GeminiHeadlessRequest> {
-    public:
-        static ErrorOr<NonnullRefPtr<GeminiHeadlessRequest>> create(String const&, AK::URL const& url, HashMap<String, String> const&, ReadonlyBytes, Core::ProxyData const&)
+        ErrorOr<void> start_http2_stream()
         {
-            auto stream_backing_buffer = TRY(ByteBuffer::create_uninitialized(1 * MiB));
-            auto underlying_socket = TRY(Core::Stream::TCPSocket::connect(url.host(), url.port().value_or(80)));
-            TRY(underlying_socket->set_blocking(false));
-            auto socket = TRY(Core::Stream::BufferedSocket<Core::Stream::TCPSocket>::create(move(underlying_socket)));
+            m_http2_connection = TRY(m_http2_connect());
 
-            Gemini::GeminiRequest request;
-            request.set_url(url);
-
-            return adopt_ref(*new GeminiHeadlessRequest(move(request), move(socket), move(stream_backing_buffer)));
+            Http2Connection::StreamCallbacks callbacks;
+            callbacks.on_headers_received = [weak_this = make_weak_ptr()](auto& response_headers, auto response_code) {
+                if (auto strong_this = weak_this.strong_ref())
+                    strong_this->did_receive_headers(response_headers, response_code);
+            };
+            callbacks.on_data_received = [weak_this = make_weak_ptr()](ReadonlyBytes data) {
+                auto strong_this = weak_this.strong_ref();
+                if (!strong_this)
+                    return;
+                if (auto result = strong_this->m_output_stream->write(data); result.is_error()) {
+                    dbgln("BufferedHeadlessRequest: Failed to buffer the response: {}", result.error());
+                    strong_this->m_http2_connection->cancel_stream(strong_this->m_http2_stream_token);
+                    strong_this->m_http2_connection = nullptr;
+                    Core::deferred_invoke([strong_this] {
+                        strong_this->did_finish(false);
+                    });
+                    return;
+                }
+                strong_this->did_receive_data();
+            };
+            callbacks.on_finish = [weak_this = make_weak_ptr()](auto result) {
+                if (auto strong_this = weak_this.strong_ref()) {
+                    strong_this->m_http2_stream_result = result;
+                    strong_this->m_http2_connection = nullptr;
+                    strong_this->did_finish(result == Http2Connection::StreamResult::Complete);
+                }
+            };
+            m_http2_stream_token = m_http2_connection->start_stream(m_http2_request, move(callbacks));
+            return {};
         }
 
-        virtual ~GeminiHeadlessRequest() override
+        bool should_retry(bool success) const
         {
+            // Only a request that got nothing back may be sent again.
+            if (success || m_response_code.has_value() || m_output_stream->size() != 0)
+                return false;
+            if (m_http2_connect) {
+                if (m_has_retried_http2_stream)
+                    return false;
+                return m_http2_stream_result == Http2Connection::StreamResult::Refused || is_idempotent(m_http2_request);
+            }
+            return m_socket_was_reused && m_connect_fresh;
         }
 
-        virtual void set_should_buffer_all_input(bool) override
+        void retry_on_fresh_connection()
         {
-        }
+            if (m_http2_connect) {
+                // The pool hands out a new connection if the old one is done for, or the same one if it merely refused the stream.
+                m_has_retried_http2_stream = true;
+                ConnectionPool::the().did_retry_request();
+                if (auto result = start_http2_stream(); result.is_error()) {
+                    dbgln("BufferedHeadlessRequest: Failed to reconnect for a retry: {}", result.error());
+                    did_finish(false);
+                }
+                return;
+            }
 
-        virtual bool stop() override
-        {
-            return false;
+            // There's only ever one retry.
+            m_socket_was_reused = false;
+
+            auto socket_or_error = m_connect_fresh();
+            if (socket_or_error.is_error()) {
+                dbgln("BufferedHeadlessRequest: Failed to reconnect for a retry: {}", socket_or_error.error());
+                did_finish(false);
+                return;
+            }
+            ConnectionPool::the().did_open_connection();
+            ConnectionPool::the().did_retry_request();
+
+            // The failed job has detached from the old socket, which is no use to anyone now.
+            m_socket = socket_or_error.release_value();
+            m_job->on_headers_received = nullptr;
+            m_job->on_progress = nullptr;
+            m_job->on_finish = nullptr;
+            m_job = m_create_job(*m_output_stream);
+            start_job();
         }
 
-        virtual void stream_into(Core::Stream::Stream&) override
+        void did_finish(bool success)
         {
+            if (should_retry(success)) {
+                retry_on_fresh_connection();
+                return;
+            }
+
+            m_has_finished = true;
+            m_success = success;
+            m_finished_timer.start();
+            m_preload_scanner = nullptr;
+
+            // The job has detached from the socket by now, and closed it if the server asked for that.
+            if (success && m_socket && !m_connection_pool_origin.is_null())
+                ConnectionPool::the().give_back(m_connection_pool_origin, m_socket.release_nonnull());
+
+            // Otherwise this is a speculative request nobody has asked for yet, and the response waits for did_claim().
+            if (on_buffered_request_finish)
+                deliver_response();
         }
 
-    private:
-        GeminiHeadlessRequest(Gemini::GeminiRequest&& request, NonnullOwnPtr<Core::Stream::BufferedSocketBase> socket, ByteBuffer&& stream_backing_buffer)
-            : m_stream_backing_buffer(move(stream_backing_buffer))
-            , m_output_stream(Core::Stream::MemoryStream::construct(m_stream_backing_buffer.bytes()).release_value_but_fixme_should_propagate_errors())
-            , m_socket(move(socket))
-            , m_job(Gemini::Job::construct(move(request), *m_output_stream))
+        void deliver_response()
         {
-            m_job->on_headers_received = [weak_this = make_weak_ptr()](auto& response_headers, auto response_code) mutable {
-                if (auto strong_this = weak_this.strong_ref()) {
-                    strong_this->m_response_code = response_code;
-                    for (auto& header : response_headers) {
-                        strong_this->m_response_headers.set(header.key, header.value);
-                    }
-                }
-            };
-            m_job->on_finish = [weak_this = make_weak_ptr()](bool success) mutable {
-                Core::deferred_invoke([weak_this, success]() mutable {
-                    if (auto strong_this = weak_this.strong_ref()) {
-                        ReadonlyBytes response_bytes { strong_this->m_output_stream->bytes().data(), strong_this->m_output_stream->offset() };
-                        auto response_buffer = ByteBuffer::copy(response_bytes).release_value_but_fixme_should_propagate_errors();
-                        strong_this->on_buffered_request_finish(success, strong_this->m_output_stream->offset(), strong_this->m_response_headers, strong_this->m_response_code, response_buffer);
-                    } });
-            };
-            m_job->start(*m_socket);
+            NonnullRefPtr protector = *this;
+
+            // The ResourceLoader copies whatever it keeps, so it gets a view of our buffer rather than a copy of it.
+            // Afterwards the buffer goes straight back to the pool for the next request.
+            auto& output_stream = *m_output_stream;
+            on_buffered_request_finish(m_success, output_stream.size(), m_response_headers, m_response_code, output_stream.bytes());
+            output_stream.release_buffer();
+            ResponseBufferPool::the().did_finish_request();
+            s_all_requests.remove(protector);
         }
 
         Optional<u32> m_response_code;
-        ByteBuffer m_stream_backing_buffer;
-        NonnullOwnPtr<Core::Stream::MemoryStream> m_output_stream;
-        NonnullOwnPtr<Core::Stream::BufferedSocketBase> m_socket;
-        NonnullRefPtr<Gemini::Job> m_job;
+        NonnullOwnPtr<PooledResponseStream> m_output_stream;
+        OwnPtr<Core::Stream::BufferedSocketBase> m_socket;
+        bool m_socket_was_reused { false };
+        String m_connection_pool_origin;
+        Connector m_connect_fresh;
+        JobFactory m_create_job;
+        RefPtr<Core::NetworkJob> m_job;
+        HTTP::HttpRequest m_http2_request;
+        Http2Connector m_http2_connect;
+        RefPtr<Http2Connection> m_http2_connection;
+        Http2Connection::StreamToken m_http2_stream_token { 0 };
+        Optional<Http2Connection::StreamResult> m_http2_stream_result;
+        bool m_has_retried_http2_stream { false };
         HashMap<String, String, CaseInsensitiveStringTraits> m_response_headers;
+        OwnPtr<PreloadScanner> m_preload_scanner;
+        Function<void(Vector<AK::URL>)> m_on_preload_urls;
+        bool m_has_finished { false };
+        bool m_success { false };
+        Core::ElapsedTimer m_started_timer;
+        Core::ElapsedTimer m_finished_timer;
     };
 
+    static ErrorOr<HTTP::HttpRequest> create_http_request(String const& method, AK::URL const& url, HashMap<String, String> const& request_headers, ReadonlyBytes request_body)
+    {
+        HTTP::HttpRequest request;
+        if (method.equals_ignoring_case("head"sv))
+            request.set_method(HTTP::HttpRequest::HEAD);
+        else if (method.equals_ignoring_case("get"sv))
+            request.set_method(HTTP::HttpRequest::GET);
+        else if (method.equals_ignoring_case("post"sv))
+            request.set_method(HTTP::HttpRequest::POST);
+        else
+            request.set_method(HTTP::HttpRequest::Invalid);
+        request.set_url(url);
+        request.set_headers(request_headers);
+        request.set_body(TRY(ByteBuffer::copy(request_body)));
+        return request;
+    }
+
+    template<typename SocketType>
+    static ErrorOr<NonnullOwnPtr<Core::Stream::BufferedSocketBase>> connect(AK::URL const& url, u16 default_port)
+    {
+        auto underlying_socket = TRY(SocketType::connect(url.host(), url.port().value_or(default_port)));
+        TRY(underlying_socket->set_blocking(false));
+        return TRY(Core::Stream::BufferedSocket<SocketType>::create(move(underlying_socket)));
+    }
+
+    template<typename SocketType>
+    static ErrorOr<NonnullOwnPtr<Core::Stream::BufferedSocketBase>> take_or_connect(String const& origin, AK::URL const& url, u16 default_port, bool& was_reused)
+    {
+        auto& connection_pool = ConnectionPool::the();
+        if (auto socket = connection_pool.take(origin)) {
+            was_reused = true;
+            return socket.release_nonnull();
+        }
+        was_reused = false;
+        connection_pool.did_open_connection();
+        return connect<SocketType>(url, default_port);
+    }
+
+    // Only requests without side effects may be sent twice.
+    static bool is_idempotent(HTTP::HttpRequest const& request)
+    {
+        return request.method() == HTTP::HttpRequest::GET || request.method() == HTTP::HttpRequest::HEAD;
+    }
+
+    template<typename SocketType>
+    static BufferedHeadlessRequest::Connector fresh_connector_for(HTTP::HttpRequest const& request, AK::URL const& url, u16 default_port)
+    {
+        if (!is_idempotent(request))
+            return nullptr;
+        return [url, default_port] {
+            return connect<SocketType>(url, default_port);
+        };
+    }
+
+    static ErrorOr<NonnullRefPtr<BufferedHeadlessRequest>> start_http_request(String const& method, AK::URL const& url, HashMap<String, String> const& request_headers, ReadonlyBytes request_body, Core::ProxyData const&)
+    {
+        auto origin = ConnectionPool::origin_key(url, 80);
+        if (ConnectionPool::the().has_http2_prior_knowledge()) {
+            auto request = TRY(create_http_request(method, url, request_headers, request_body));
+            return BufferedHeadlessRequest::create_http2(move(request), [origin = move(origin), url] {
+                return ConnectionPool::the().take_http2_connection(origin, url, 80);
+            });
+        }
+
+        bool socket_was_reused = false;
+        auto socket = TRY(take_or_connect<Core::Stream::TCPSocket>(origin, url, 80, socket_was_reused));
+        auto request = TRY(create_http_request(method, url, request_headers, request_body));
+        auto connect_fresh = fresh_connector_for<Core::Stream::TCPSocket>(request, url, 80);
+
+        return BufferedHeadlessRequest::create(move(socket), socket_was_reused, move(origin), move(connect_fresh), [request = move(request)](auto& output_stream) {
+            return HTTP::Job::construct(HTTP::HttpRequest { request }, output_stream);
+        });
+    }
+
+    static ErrorOr<NonnullRefPtr<BufferedHeadlessRequest>> start_https_request(String const& method, AK::URL const& url, HashMap<String, String> const& request_headers, ReadonlyBytes request_body, Core::ProxyData const&)
+    {
+        auto origin = ConnectionPool::origin_key(url, 443);
+        bool socket_was_reused = false;
+        auto socket = TRY(take_or_connect<TLS::TLSv12>(origin, url, 443, socket_was_reused));
+        auto request = TRY(create_http_request(method, url, request_headers, request_body));
+        auto connect_fresh = fresh_connector_for<TLS::TLSv12>(request, url, 443);
+
+        return BufferedHeadlessRequest::create(move(socket), socket_was_reused, move(origin), move(connect_fresh), [request = move(request)](auto& output_stream) {
+            return HTTP::HttpsJob::construct(HTTP::HttpRequest { request }, output_stream);
+        });
+    }
+
+    static ErrorOr<NonnullRefPtr<BufferedHeadlessRequest>> start_gemini_request(String const&, AK::URL const& url, HashMap<String, String> const&, ReadonlyBytes, Core::ProxyData const&)
+    {
+        // Gemini closes the connection after every response, so there's nothing to pool.
+        auto socket = TRY(connect<Core::Stream::TCPSocket>(url, 80));
+
+        Gemini::GeminiRequest request;
+        request.set_url(url);
+
+        return BufferedHeadlessRequest::create(move(socket), false, {}, nullptr, [request = move(request)](auto& output_stream) {
+            return Gemini::Job::construct(Gemini::GeminiRequest { request }, output_stream);
+        });
+    }
+
     static NonnullRefPtr<HeadlessRequestServer> create()
     {
         return adopt_ref(*new HeadlessRequestServer());
@@ -659,48 +1039,181 @@ public:
 
     virtual ~HeadlessRequestServer() override { }
 
+    // Drops every speculative request the page hasn't asked for yet, in flight or not, and returns the bytes of
+    // response data that were buffered for them.
+    size_t discard_unclaimed_speculative_requests()
+    {
+        Vector<String> urls;
+        for (auto& it : m_speculative_requests)
+            urls.append(it.key);
+        return discard_speculative_requests(urls);
+    }
+
     virtual void prefetch_dns(AK::URL const&) override { }
     virtual void preconnect(AK::URL const&) override { }
 
     virtual RefPtr<Web::ResourceLoaderConnectorRequest> start_request(String const& method, AK::URL const& url, HashMap<String, String> const& request_headers, ReadonlyBytes request_body, Core::ProxyData const& proxy) override
     {
-        RefPtr<Web::ResourceLoaderConnectorRequest> request;
-        if (url.protocol().equals_ignoring_case("http"sv)) {
-            auto request_or_error = HTTPHeadlessRequest::create(method, url, request_headers, request_body, proxy);
-            if (request_or_error.is_error())
-                return {};
-            request = request_or_error.release_value();
-        }
-        if (url.protocol().equals_ignoring_case("https"sv)) {
-            auto request_or_error = HTTPSHeadlessRequest::create(method, url, request_headers, request_body, proxy);
-            if (request_or_error.is_error())
-                return {};
-            request = request_or_error.release_value();
-        }
-        if (url.protocol().equals_ignoring_case("gemini"sv)) {
-            auto request_or_error = GeminiHeadlessRequest::create(method, url, request_headers, request_body, proxy);
-            if (request_or_error.is_error())
-                return {};
-            request = request_or_error.release_value();
-        }
-        if (request)
+        discard_stale_speculative_requests();
+
+        if (auto request = take_speculative_request(method, url, request_headers, request_body)) {
             s_all_requests.set(request);
+            request->did_claim();
+            return request;
+        }
+
+        auto request = start_protocol_request(method, url, request_headers, request_body, proxy);
+        if (!request)
+            return {};
+        s_all_requests.set(request);
+
+        if (method.equals_ignoring_case("get"sv)) {
+            // Whatever the document refers to is requested with the same headers, minus the cookies.
+            // Those get attached by the ResourceLoader for each resource, so they can't be guessed here.
+            // If the document's host uses cookies, its own resources aren't worth guessing at.
+            auto speculative_request_headers = request_headers;
+            String host_with_cookies;
+            if (speculative_request_headers.remove("Cookie"))
+                host_with_cookies = url.host();
+            request->enable_preload_scanning(url, [this, speculative_request_headers = move(speculative_request_headers), host_with_cookies = move(host_with_cookies)](Vector<AK::URL> urls) {
+                urls.remove_all_matching([&](auto& url) { return url.host() == host_with_cookies; });
+                // Low priority: the requests go out after the response data that revealed them has been dealt with,
+                // and only as many of them as we're willing to have outstanding.
+                Core::deferred_invoke([this, urls = move(urls), request_headers = speculative_request_headers] {
+                    start_speculative_requests(urls, request_headers);
+                });
+            });
+        }
         return request;
     }
 
 private:
+    // Upper bound on speculative requests, whether in flight or complete and waiting for the ResourceLoader.
+    static constexpr size_t max_speculative_requests = 16;
+
+    // Complete speculative responses that haven't been asked for within this time probably never will be.
+    static constexpr int speculative_response_timeout_ms = 10000;
+
+    // A speculative request that takes longer than this is holding a connection that the page needs more.
+    static constexpr int speculative_request_timeout_ms = 30000;
+
+    static constexpr int speculative_request_check_interval_ms = 1000;
+
+    struct SpeculativeRequestStatistics {
+        size_t started { 0 };
+        size_t used { 0 };
+        size_t discarded { 0 };
+    };
+
     HeadlessRequestServer() { }
+
+    RefPtr<BufferedHeadlessRequest> start_protocol_request(String const& method, AK::URL const& url, HashMap<String, String> const& request_headers, ReadonlyBytes request_body, Core::ProxyData const& proxy)
+    {
+        auto request_or_error = [&]() -> ErrorOr<NonnullRefPtr<BufferedHeadlessRequest>> {
+            if (url.protocol().equals_ignoring_case("http"sv))
+                return start_http_request(method, url, request_headers, request_body, proxy);
+            if (url.protocol().equals_ignoring_case("https"sv))
+                return start_https_request(method, url, request_headers, request_body, proxy);
+            if (url.protocol().equals_ignoring_case("gemini"sv))
+                return start_gemini_request(method, url, request_headers, request_body, proxy);
+            return Error::from_errno(EPROTONOSUPPORT);
+        }();
+        if (request_or_error.is_error())
+            return {};
+        return request_or_error.release_value();
+    }
+
+    void start_speculative_requests(Vector<AK::URL> const& urls, HashMap<String, String> const& request_headers)
+    {
+        for (auto& url : urls) {
+            if (m_speculative_requests.size() >= max_speculative_requests)
+                return;
+            auto key = url.to_string();
+            if (m_speculative_requests.contains(key))
+                continue;
+            auto request = start_protocol_request("GET", url, request_headers, {}, {});
+            if (!request)
+                continue;
+            m_speculative_requests.set(key, request.release_nonnull());
+            ++m_speculative_request_statistics.started;
+        }
+
+        if (m_speculative_requests.is_empty())
+            return;
+        if (!m_speculative_request_timer) {
+            m_speculative_request_timer = Core::Timer::create_repeating(speculative_request_check_interval_ms, [this] {
+                discard_stale_speculative_requests();
+            });
+        }
+        m_speculative_request_timer->start();
+    }
+
+    RefPtr<BufferedHeadlessRequest> take_speculative_request(String const& method, AK::URL const& url, HashMap<String, String> const& request_headers, ReadonlyBytes request_body)
+    {
+        if (m_speculative_requests.is_empty())
+            return {};
+        // A response fetched without cookies isn't necessarily the one we would have gotten with them.
+        if (!method.equals_ignoring_case("get"sv) || !request_body.is_empty() || request_headers.contains("Cookie"))
+            return {};
+
+        auto request = m_speculative_requests.take(url.to_string());
+        if (!request.has_value())
+            return {};
+        if (request.value()->has_failed()) {
+            ++m_speculative_request_statistics.discarded;
+            return {};
+        }
+        ++m_speculative_request_statistics.used;
+        return request.release_value();
+    }
+
+    void discard_stale_speculative_requests()
+    {
+        Vector<String> stale_urls;
+        for (auto& it : m_speculative_requests) {
+            auto& request = *it.value;
+            if (request.has_finished() ? request.finished_timer().elapsed() >= speculative_response_timeout_ms : request.started_timer().elapsed() >= speculative_request_timeout_ms)
+                stale_urls.append(it.key);
+        }
+        discard_speculative_requests(stale_urls);
+    }
+
+    size_t discard_speculative_requests(Vector<String> const& urls)
+    {
+        size_t freed_bytes = 0;
+        for (auto& url : urls) {
+            auto request = m_speculative_requests.take(url).release_value();
+            freed_bytes += request->buffered_size();
+            request->cancel();
+        }
+
+        if (m_speculative_requests.is_empty() && m_speculative_request_timer)
+            m_speculative_request_timer->stop();
+        if (urls.is_empty())
+            return 0;
+
+        auto& statistics = m_speculative_request_statistics;
+        statistics.discarded += urls.size();
+        dbgln("Preload scanner: {} speculative requests started, {} used by the page, {} discarded", statistics.started, statistics.used, statistics.discarded);
+        return freed_bytes;
+    }
+
+    HashMap<String, NonnullRefPtr<BufferedHeadlessRequest>> m_speculative_requests;
+    SpeculativeRequestStatistics m_speculative_request_statistics;
+    RefPtr<Core::Timer> m_speculative_request_timer;
 };
 
+static RefPtr<HeadlessRequestServer> s_request_server;
+
 class HeadlessWebSocketClientManager : public Web::WebSockets::WebSocketClientManager {
 public:
     class HeadlessWebSocket
         : public Web::WebSockets::WebSocketClientSocket
         , public Weakable<HeadlessWebSocket> {
     public:
-        static NonnullRefPtr<HeadlessWebSocket> create(NonnullRefPtr<WebSocket::WebSocket> underlying_socket)
+        static NonnullRefPtr<HeadlessWebSocket> create(AK::URL url, NonnullRefPtr<WebSocket::WebSocket> underlying_socket)
         {
-            return adopt_ref(*new HeadlessWebSocket(move(underlying_socket)));
+            return adopt_ref(*new HeadlessWebSocket(move(url), move(underlying_socket)));
         }
 
         virtual ~HeadlessWebSocket() override
@@ -724,11 +1237,15 @@ public:
 
         virtual void send(ByteBuffer binary_or_text_message, bool is_text) override
         {
-            m_websocket->send(WebSocket::Message(binary_or_text_message, is_text));
+            did_send(binary_or_text_message.size());
+            // The payload is ours to give away, so it moves into the message instead of being copied.
+            m_websocket->send(WebSocket::Message(move(binary_or_text_message), is_text));
         }
 
         virtual void send(StringView message) override
         {
+            did_send(message.length());
+            // This is only a view of a string LibWeb keeps, so the frame needs a copy of it.
             m_websocket->send(WebSocket::Message(message));
         }
 
@@ -738,16 +1255,28 @@ public:
         }
 
     private:
-        HeadlessWebSocket(NonnullRefPtr<WebSocket::WebSocket> underlying_socket)
-            : m_websocket(move(underlying_socket))
+        struct Statistics {
+            size_t messages_sent { 0 };
+            size_t bytes_sent { 0 };
+            size_t messages_received { 0 };
+            size_t bytes_received { 0 };
+        };
+
+        HeadlessWebSocket(AK::URL url, NonnullRefPtr<WebSocket::WebSocket> underlying_socket)
+            : m_url(move(url))
+            , m_websocket(move(underlying_socket))
         {
             m_websocket->on_open = [weak_this = make_weak_ptr()] {
-                if (auto strong_this = weak_this.strong_ref())
+                if (auto strong_this = weak_this.strong_ref()) {
+                    strong_this->m_open_timer.start();
                     if (strong_this->on_open)
                         strong_this->on_open();
+                }
             };
             m_websocket->on_message = [weak_this = make_weak_ptr()](auto message) {
                 if (auto strong_this = weak_this.strong_ref()) {
+                    ++strong_this->m_statistics.messages_received;
+                    strong_this->m_statistics.bytes_received += message.data().size();
                     if (strong_this->on_message) {
                         strong_this->on_message(Web::WebSockets::WebSocketClientSocket::Message {
                             .data = move(message.data()),
@@ -775,13 +1304,40 @@ public:
                 }
             };
             m_websocket->on_close = [weak_this = make_weak_ptr()](u16 code, String reason, bool was_clean) {
-                if (auto strong_this = weak_this.strong_ref())
+                if (auto strong_this = weak_this.strong_ref()) {
+                    strong_this->report_throughput();
                     if (strong_this->on_close)
                         strong_this->on_close(code, move(reason), was_clean);
+                }
             };
         }
 
+        void did_send(size_t bytes)
+        {
+            ++m_statistics.messages_sent;
+            m_statistics.bytes_sent += bytes;
+        }
+
+        void report_throughput() const
+        {
+            if (!m_open_timer.is_valid())
+                return;
+            auto seconds = max(m_open_timer.elapsed(), 1) / 1000.0;
+            dbgln("WebSocket {}: Sent {} messages ({} bytes, {:.2} MiB/s), received {} messages ({} bytes, {:.2} MiB/s) in {:.2}s",
+                m_url,
+                m_statistics.messages_sent,
+                m_statistics.bytes_sent,
+                m_statistics.bytes_sent / seconds / MiB,
+                m_statistics.messages_received,
+                m_statistics.bytes_received,
+                m_statistics.bytes_received / seconds / MiB,
+                seconds);
+        }
+
+        AK::URL m_url;
         NonnullRefPtr<WebSocket::WebSocket> m_websocket;
+        Core::ElapsedTimer m_open_timer;
+        Statistics m_statistics;
     };
 
     static NonnullRefPtr<HeadlessWebSocketClientManager> create()
@@ -796,7 +1352,7 @@ public:
         WebSocket::ConnectionInfo connection_info(url);
         connection_info.set_origin(origin);
 
-        auto connection = HeadlessWebSocket::create(WebSocket::WebSocket::create(move(connection_info)));
+        auto connection = HeadlessWebSocket::create(url, WebSocket::WebSocket::create(move(connection_info)));
         return connection;
     }
 
@@ -806,8 +1362,13 @@ private:
 
 void initialize_web_engine()
 {
+    s_launch_timer.start();
+    if (auto startup_time = milliseconds_since_process_start(); startup_time.has_value())
+        dbgln("Process start to engine initialization: {}ms", *startup_time);
+
     Web::ImageDecoding::Decoder::initialize(HeadlessImageDecoderClient::create());
-    Web::ResourceLoader::initialize(HeadlessRequestServer::create());
+    s_request_server = HeadlessRequestServer::create();
+    Web::ResourceLoader::initialize(s_request_server);
     Web::WebSockets::WebSocketClientManager::initialize(HeadlessWebSocketClientManager::create());
 
     Web::FrameLoader::set_default_favicon_path(String::formatted("{}/res/icons/16x16/app-browser.png", s_serenity_resource_root));
@@ -819,4 +1380,25 @@ void initialize_web_engine()
     Gfx::FontDatabase::set_fixed_width_font_query("Csilla 10 400 0");
 
     Web::FrameLoader::set_error_page_url(String::formatted("file://{}/res/html/error.html", s_serenity_resource_root));
+
+    s_theme_buffer = Gfx::load_system_theme(String::formatted("{}/res/themes/Default.ini", s_serenity_resource_root));
+}
+
+void populate_font_database()
+{
+    // The font database is otherwise populated on first use, in the middle of the first layout.
+    auto font_database_timer = Core::ElapsedTimer::start_new();
+    (void)Gfx::FontDatabase::the();
+    dbgln("Populated font database in {}ms", font_database_timer.elapsed());
+}
+
+size_t discard_unclaimed_speculative_requests()
+{
+    return s_request_server->discard_unclaimed_speculative_requests();
+}
+
+void reset_launch_timer()
+{
+    s_launch_timer.start();
+    s_has_reported_first_paint = false;
 }
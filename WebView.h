@@ -8,12 +8,17 @@
 
 #define AK_DONT_REPLACE_STD
 
+#include <AK/Optional.h>
 #include <AK/OwnPtr.h>
+#include <AK/RefPtr.h>
 #include <AK/String.h>
+#include <LibCore/ElapsedTimer.h>
+#include <LibCore/Timer.h>
 #include <LibGfx/Forward.h>
+#include <LibGfx/Rect.h>
 #include <QAbstractScrollArea>
 
-class HeadlessBrowserPageClient;
+class WebContentClient;
 
 class WebView final : public QAbstractScrollArea {
     Q_OBJECT
@@ -22,9 +27,27 @@ public:
     virtual ~WebView() override;
 
     void load(String const& url);
+    void go_back();
+    void go_forward();
+
+    // Inactive views never paint and only remember that their contents changed. Their WebContent process runs at a
+    // lower priority, where we're able to raise it back afterwards.
+    bool is_active() const { return m_active; }
+    void set_active(bool);
+
+    // The display frame clock: main() processes Qt's events and then calls this, once per frame_interval_ms().
+    // Mouse moves and invalidations that came in since the last tick go out to the WebContent process together.
+    static int frame_interval_ms();
+    static void dispatch_scheduled_frames();
+
+    void did_invalidate();
+    // Returns the number of bytes freed.
+    size_t discard_backing_store();
+    bool has_backing_store() const { return !m_front_backing_store.bitmap.is_null(); }
 
     virtual void paintEvent(QPaintEvent*) override;
     virtual void resizeEvent(QResizeEvent*) override;
+    virtual void scrollContentsBy(int dx, int dy) override;
     virtual void mouseMoveEvent(QMouseEvent*) override;
     virtual void mousePressEvent(QMouseEvent*) override;
     virtual void mouseReleaseEvent(QMouseEvent*) override;
@@ -34,9 +57,90 @@ signals:
     void linkUnhovered();
     void loadStarted(QString);
     void title_changed(QString);
+    void history_state_changed(bool can_go_back, bool can_go_forward);
 
 private:
+    struct SharedBackingStore {
+        i32 id { -1 };
+        RefPtr<Gfx::Bitmap> bitmap;
+    };
+
     Gfx::IntPoint to_content(Gfx::IntPoint) const;
+    Gfx::IntRect content_rect() const;
+
+    void spawn_web_content_process();
+    void did_crash();
+
+    // Hidden tabs' WebContent processes run at a lower CPU priority, so they can't slow down the visible one.
+    void update_web_content_priority();
+
+    void request_repaint();
+    void schedule_frame();
+    void dispatch_frame();
+    void dispatch_pending_mouse_move();
+
+    // Returns whether the WebContent process was sent a new viewport size.
+    bool apply_pending_viewport_size();
+    void did_finish_resizing();
+    void report_resize_statistics();
+    void send_paint_request_if_needed();
+    bool ensure_back_backing_store();
+    void did_paint(i32 backing_store_id, Gfx::IntRect const& content_rect, u32 paint_time_ms);
+    void update_frame_statistics(u32 paint_time_ms);
+
+    RefPtr<WebContentClient> m_client;
+
+    Gfx::IntRect m_viewport_rect;
+    bool m_active { true };
+
+    // Frames are painted by the WebContent process into the back backing store, then swapped to the front for display.
+    SharedBackingStore m_front_backing_store;
+    SharedBackingStore m_back_backing_store;
+    Gfx::IntRect m_front_content_rect;
+    i32 m_next_backing_store_id { 0 };
+    bool m_has_paint_in_flight { false };
+    bool m_needs_repaint { true };
+
+    // A frame is dropped when it's replaced by a newer one before any paintEvent got to show it.
+    struct FrameStatistics {
+        size_t frames_produced { 0 };
+        size_t frames_dropped { 0 };
+        u64 total_paint_time_ms { 0 };
+        u32 max_paint_time_ms { 0 };
+        u64 total_latency_ms { 0 };
+        u32 max_latency_ms { 0 };
+    };
+    FrameStatistics m_frame_statistics;
+    Core::ElapsedTimer m_paint_request_timer;
+    bool m_front_frame_was_presented { true };
+
+    // Invalidations and mouse moves are coalesced and sent to the WebContent process at most once per display frame.
+    struct PendingMouseMove {
+        Gfx::IntPoint position;
+        unsigned buttons { 0 };
+        unsigned modifiers { 0 };
+    };
+    Optional<PendingMouseMove> m_pending_mouse_move;
+
+    struct EventCounters {
+        size_t invalidations_received { 0 };
+        size_t paints_dispatched { 0 };
+        size_t mouse_moves_received { 0 };
+        size_t mouse_moves_dispatched { 0 };
+    };
+    EventCounters m_event_counters;
+
+    static constexpr int resize_relayout_interval_ms = 100;
+    static constexpr int resize_settle_delay_ms = 150;
 
-    OwnPtr<HeadlessBrowserPageClient> m_page_client;
+    struct ResizeStatistics {
+        size_t resize_events { 0 };
+        size_t relayouts { 0 };
+    };
+    ResizeStatistics m_resize_statistics;
+    Gfx::IntSize m_pending_viewport_size;
+    Core::ElapsedTimer m_last_resize_relayout_timer;
+    RefPtr<Core::Timer> m_resize_settle_timer;
+    Core::ElapsedTimer m_settled_frame_timer;
+    bool m_is_waiting_for_settled_frame { false };
 };
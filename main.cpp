@@ -5,36 +5,98 @@
  */
 
 #include "BrowserWindow.h"
+#include "ConnectionPool.h"
+#include "ForkServer.h"
+#include "MemoryPressureMonitor.h"
+#include "ResponseBufferBenchmark.h"
+#include "WebContentProcess.h"
+#include "WebContentSpawner.h"
+#include "WebSocketEchoBenchmark.h"
 #include "WebView.h"
 #include <LibCore/ArgsParser.h>
 #include <LibCore/EventLoop.h>
+#include <LibCore/System.h>
 #include <LibCore/Timer.h>
 #include <LibMain/Main.h>
 #include <QApplication>
 #include <QWidget>
+#include <signal.h>
 
 extern void initialize_web_engine();
+extern void populate_font_database();
+extern void reset_launch_timer();
 
 ErrorOr<int> serenity_main(Main::Arguments arguments)
 {
     initialize_web_engine();
 
     String url;
+    String fork_server_socket_path;
+    int max_active_tabs = 3;
+    int back_forward_cache_size_in_mib = 64;
+    int memory_limit_in_mib = 0;
+    bool http2_prior_knowledge = false;
+    String websocket_echo_benchmark_url;
+    int websocket_benchmark_message_count = 10000;
+    int websocket_benchmark_message_size = 1024;
+    int response_buffer_benchmark_requests = 0;
     Core::ArgsParser args_parser;
     args_parser.set_general_help("The Ladybird web browser :^)");
+    args_parser.add_option(fork_server_socket_path, "Wait on a local socket and open every URL written to it in a new pre-initialized browser", "fork-server", 0, "path");
+    args_parser.add_option(max_active_tabs, "Number of most recently shown tabs that keep their painted contents while hidden (default: 3)", "max-active-tabs", 0, "count");
+    args_parser.add_option(back_forward_cache_size_in_mib, "Estimated memory that each tab may use to keep pages for back/forward navigation, in MiB (default: 64)", "back-forward-cache-size", 0, "MiB");
+    args_parser.add_option(memory_limit_in_mib, "Resident memory per process at which to start shedding caches, in MiB (default: no limit, only react to system memory pressure)", "memory-limit", 0, "MiB");
+    args_parser.add_option(http2_prior_knowledge, "Send http:// requests over HTTP/2 without asking the server first, for servers known to support it", "http2-prior-knowledge", 0);
+    args_parser.add_option(websocket_echo_benchmark_url, "Measure WebSocket throughput against the echo server at this URL, then exit", "websocket-echo-benchmark", 0, "url");
+    args_parser.add_option(websocket_benchmark_message_count, "Number of messages for --websocket-echo-benchmark (default: 10000)", "websocket-benchmark-messages", 0, "count");
+    args_parser.add_option(websocket_benchmark_message_size, "Size of each message for --websocket-echo-benchmark, in bytes (default: 1024)", "websocket-benchmark-message-size", 0, "bytes");
+    args_parser.add_option(response_buffer_benchmark_requests, "Measure response buffer allocations and copies with this many synthetic responses of each size, then exit", "response-buffer-benchmark", 0, "count");
     args_parser.add_positional_argument(url, "URL to open", "url", Core::ArgsParser::Required::No);
     args_parser.parse(arguments);
 
+    if (!fork_server_socket_path.is_empty()) {
+        // Every forked browser inherits the populated database, so it's worth paying for once up front.
+        // A regular launch leaves it to the first layout, which may not need all of it.
+        populate_font_database();
+
+        // Only returns in the forked child, which then starts up as a regular browser.
+        url = TRY(run_fork_server(fork_server_socket_path));
+        reset_launch_timer();
+    }
+
+    set_back_forward_cache_budget(max(back_forward_cache_size_in_mib, 0) * MiB);
+    ConnectionPool::the().set_http2_prior_knowledge(http2_prior_knowledge);
+
+    // Writes to a crashed WebContent process should fail, not kill us.
+    TRY(Core::System::signal(SIGPIPE, SIG_IGN));
+
+    if (response_buffer_benchmark_requests > 0)
+        return run_response_buffer_benchmark(response_buffer_benchmark_requests);
+
+    if (!websocket_echo_benchmark_url.is_empty())
+        return run_websocket_echo_benchmark(AK::URL(websocket_echo_benchmark_url), max(websocket_benchmark_message_count, 0), max(websocket_benchmark_message_size, 0));
+
     Core::EventLoop event_loop;
 
+    // WebContent processes inherit the limit from the spawner, so it has to be set before that's forked.
+    MemoryPressureMonitor::the().set_rss_limit(max(memory_limit_in_mib, 0) * MiB);
+
+    // Before Qt and any tab exist, so WebContent processes don't inherit them. See WebContentSpawner.h.
+    TRY(start_web_content_spawner());
+
+    MemoryPressureMonitor::the().start();
+
     QApplication app(arguments.argc, arguments.argv);
-    BrowserWindow window;
+    BrowserWindow window(max(max_active_tabs, 1));
     window.setWindowTitle("Ladybird");
     window.resize(800, 600);
     window.show();
 
-    auto qt_event_loop_driver = Core::Timer::create_repeating(50, [&] {
+    // Qt's events are processed once per display frame, right before the frame's work is handed to the WebContent
+    // processes. That way input and paint requests go out at the display's rate, not at whatever rate we'd poll Qt at.
+    auto qt_event_loop_driver = Core::Timer::create_repeating(WebView::frame_interval_ms(), [&] {
         app.processEvents();
+        WebView::dispatch_scheduled_frames();
     });
     qt_event_loop_driver->start();
 